@@ -0,0 +1,38 @@
+/*
+   Listen-only CAN bit rate detection
+   Cycles candidate rates with the controller in listen-only mode so nothing
+   (not even an ACK) is driven onto a bus we don't know the speed of yet.
+ */
+
+#ifndef BAUD_DETECT_H
+#define BAUD_DETECT_H
+
+#include <stdint.h>
+
+static const uint32_t baudRetryMs = 100; // one candidate window
+
+struct BaudDetectResult {
+  uint32_t baud;       // rate the controller was left running at
+  bool locked;         // true if a candidate was clean for a full window
+  bool listenOnly;     // controller left in listen-only mode
+  bool sawTraffic;     // frames or errors at any rate
+  uint32_t lockMillis; // time spent detecting
+  uint16_t frames;     // valid frames seen in the winning window
+  uint16_t errors;     // error events seen across the whole sweep
+};
+
+// sweeps the candidate rates until one is clean or the budget runs out,
+// then leaves Can0 running at the chosen rate. without a lock that is the
+// fallback, still listen-only
+BaudDetectResult detectBaud(uint32_t fallbackBaud);
+
+// after detectBaud() left the controller listen-only: call every
+// baudRetryMs with the frames decoded since the last call. scores the
+// window that just ended, and moves to the next candidate if it wasn't
+// clean. returns true with the rate once one is, then call joinBus()
+bool retryBaud(uint16_t frames, uint32_t now, uint32_t &baud);
+
+// leaves listen-only mode, once a rate has scored clean
+void joinBus(void);
+
+#endif
@@ -0,0 +1,56 @@
+/*
+   CAN bus statistics
+   Keeps per-ID frame rate and arrival jitter in a fixed table and estimates
+   how much of the bus is in use from each frame's length on the wire.
+   Rates and load are over the last completed one second window. Windows
+   tumble, they don't slide: the figures change once a second and always
+   cover the whole of the second before.
+ */
+
+#ifndef BUS_STATS_H
+#define BUS_STATS_H
+
+#include <stdint.h>
+
+struct IdStats {
+  uint32_t id;
+  bool used;
+  uint16_t count;    // frames so far in this window
+  uint16_t rate;     // frames in the last window, so Hz
+  uint32_t last;     // arrival of the last frame, us
+  uint32_t interval; // smoothed time between frames, us
+  uint32_t jitter;   // smoothed deviation from that, us
+};
+
+class BusStats {
+public:
+  static const int idBits = 5;
+  static const int maxIds = 1 << idBits;
+  static const uint32_t windowMicros = 1000000;
+
+  explicit BusStats(uint32_t baud);
+  void setBaud(uint32_t baud) { bitRate = baud; }
+
+  // per frame, a hash probe and a few adds
+  void update(uint32_t id, bool ext, uint8_t len, uint32_t now);
+
+  // closes the window if it has run out. update() calls this too, but a
+  // quiet bus needs it called from somewhere else
+  void roll(uint32_t now);
+
+  const IdStats &entry(int i) const { return ids[i]; }
+  uint32_t untracked() const { return lastUntracked; } // table was full
+
+  // in 0.1 % of the bus. min has no stuff bits, max the worst case
+  uint16_t loadMin() const;
+  uint16_t loadMax() const;
+
+private:
+  IdStats ids[maxIds];
+  uint32_t bitRate;
+  uint32_t windowStart;
+  uint32_t bits, stuffBits, untrackedFrames;
+  uint32_t lastBits, lastStuffBits, lastUntracked;
+};
+
+#endif
@@ -0,0 +1,16 @@
+/*
+   Calibration persistence
+   One CRC checked record in its own EEPROM region. Settings change rarely,
+   so unlike the stats there's no wear levelling.
+ */
+
+#ifndef CAL_STORE_H
+#define CAL_STORE_H
+
+#include "calibration.h"
+
+bool loadCalibration(Calibration &cal); // false, and cal untouched, if none
+bool saveCalibration(const Calibration &cal); // false if it didn't read back
+void printCalibration(const Calibration &cal);
+
+#endif
@@ -0,0 +1,82 @@
+/*
+   Display calibration
+   The settings that used to be compile time globals, changeable over CAN
+   and kept in EEPROM. Anything render() would otherwise work out from them
+   every frame is precomputed into DisplayTables whenever they change, so
+   the draw path costs the same as with constants.
+
+   Protocol, all frames 8 bytes on calId (extended), answered on calId + 1.
+   Requests of any other length are counted and ignored
+     request  [0] command  [1] parameter  [2..3] value, little endian
+     reply    [0] command | 0x80  [1] parameter  [2..3] value now in use
+              [4] status
+   SET changes a value in RAM and GET reads one back. SAVE writes everything
+   to EEPROM and DEFAULTS puts back the built in values without saving.
+   A SET that would leave the settings inconsistent (shift point above
+   redline, bands out of order) is refused and nothing changes.
+ */
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+
+#include "compositor.h"
+
+struct Calibration {
+  uint16_t wakeUp;   // scale only: each led is (redline - wakeUp) / numLeds
+                     // rpm, the bar still counts up from 0 rpm
+  uint16_t shiftRpm; // bar turns yellow above this
+  uint16_t redline;  // and flashes red above this
+  uint8_t brightness;
+  // battery display, whole volts
+  uint8_t batteryEmpty; // no leds at or below
+  uint8_t batteryFull;  // all leds at or above
+  uint8_t batteryLow;   // red below
+  uint8_t batteryMid;   // yellow below
+  uint8_t batteryHigh;  // green below, blue above
+};
+
+enum CalCommand {
+  CAL_SET = 1,
+  CAL_GET = 2,
+  CAL_SAVE = 3,
+  CAL_DEFAULTS = 4,
+};
+
+enum CalParam {
+  CAL_WAKEUP,
+  CAL_SHIFT_RPM,
+  CAL_REDLINE,
+  CAL_BRIGHTNESS,
+  CAL_BATTERY_EMPTY,
+  CAL_BATTERY_FULL,
+  CAL_BATTERY_LOW,
+  CAL_BATTERY_MID,
+  CAL_BATTERY_HIGH,
+  NUM_CAL_PARAMS
+};
+
+enum CalStatus {
+  CAL_OK,
+  CAL_BAD_COMMAND,
+  CAL_BAD_PARAM,
+  CAL_BAD_VALUE, // out of range or inconsistent with the others
+  CAL_NOT_SAVED,
+};
+
+// what render() reads instead of working it out per frame
+struct DisplayTables {
+  static const int maxVolts = 31; // battery index, higher reads as this
+
+  int rpmPerLed;
+  uint8_t batteryLeds[maxVolts + 1];
+  Rgb batteryColor[maxVolts + 1];
+};
+
+bool calibrationValid(const Calibration &cal);
+uint16_t calibrationGet(const Calibration &cal, int param);
+CalStatus calibrationSet(Calibration &cal, int param, uint16_t value);
+void buildTables(const Calibration &cal, DisplayTables &tables);
+
+#endif
@@ -0,0 +1,138 @@
+/*
+   Subscription based CAN dispatch
+   Components subscribe a handler to an exact ID or to an ID/mask pair.
+   Exact IDs live in a small open addressed hash table, so finding the
+   handlers for a frame costs the same however many IDs are subscribed.
+   Everything is sized at compile time, nothing is allocated.
+ */
+
+#ifndef CAN_DISPATCH_H
+#define CAN_DISPATCH_H
+
+#include <stdint.h>
+
+// Frame only needs an id member, so the same table works with FlexCAN's
+// CAN_message_t on the Teensy or a plain struct on a host
+template <typename Frame, int IdSlots = 32, int MaxHandlers = 16,
+          int MaxMasks = 4>
+class CanDispatch {
+public:
+  typedef void (*Handler)(const Frame &frame);
+
+  CanDispatch() : numHandlers(0), numMasks(0), unhandled(0) {
+    for (int i = 0; i < IdSlots; i++) {
+      slots[i].head = none;
+    }
+  }
+
+  // false if the table is full
+  bool subscribe(uint32_t id, Handler fn) {
+    if (numHandlers >= MaxHandlers) {
+      return false;
+    }
+
+    int slot = find(id);
+    if (slot < 0) {
+      return false;
+    }
+    slots[slot].id = id;
+
+    // append so handlers run in the order they subscribed
+    uint8_t index = numHandlers++;
+    handlers[index].fn = fn;
+    handlers[index].next = none;
+    uint8_t *tail = &slots[slot].head;
+    while (*tail != none) {
+      tail = &handlers[*tail].next;
+    }
+    *tail = index;
+    return true;
+  }
+
+  // matches when (frame.id & mask) == (id & mask)
+  bool subscribeMask(uint32_t id, uint32_t mask, Handler fn) {
+    if (numMasks >= MaxMasks) {
+      return false;
+    }
+    masks[numMasks].id = id & mask;
+    masks[numMasks].mask = mask;
+    masks[numMasks].fn = fn;
+    numMasks++;
+    return true;
+  }
+
+  // returns false if nothing was subscribed to the frame
+  bool dispatch(const Frame &frame) {
+    bool handled = false;
+
+    int slot = find(frame.id);
+    if (slot >= 0) {
+      for (uint8_t i = slots[slot].head; i != none; i = handlers[i].next) {
+        handlers[i].fn(frame);
+        handled = true;
+      }
+    }
+
+    for (int i = 0; i < numMasks; i++) {
+      if ((frame.id & masks[i].mask) == masks[i].id) {
+        masks[i].fn(frame);
+        handled = true;
+      }
+    }
+
+    unhandled += !handled;
+    return handled;
+  }
+
+  uint32_t unhandledFrames() const { return unhandled; }
+
+private:
+  static const uint8_t none = 0xFF;
+
+  struct Slot {
+    uint32_t id;
+    uint8_t head; // first handler, none if the slot is empty
+  };
+
+  struct HandlerEntry {
+    Handler fn;
+    uint8_t next;
+  };
+
+  struct MaskEntry {
+    uint32_t id;
+    uint32_t mask;
+    Handler fn;
+  };
+
+  static constexpr int bitsFor(int n) {
+    return n <= 1 ? 0 : 1 + bitsFor(n / 2);
+  }
+  static const int idBits = bitsFor(IdSlots);
+  static_assert(IdSlots >= 2 && (IdSlots & (IdSlots - 1)) == 0,
+                "IdSlots must be a power of two");
+
+  // the slot holding id, or the empty slot it would go in, or -1 if full.
+  // Knuth multiplicative hashing keeps the top bits of the product, which
+  // depend on every bit of the id. the low bits only depend on the low bits
+  // of the id, and all sixteen PE frames end in 0x48
+  int find(uint32_t id) const {
+    uint32_t start = (id * 2654435761u) >> (32 - idBits);
+    for (int n = 0; n < IdSlots; n++) {
+      int i = (start + n) & (IdSlots - 1);
+      if (slots[i].head == none || slots[i].id == id) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  Slot slots[IdSlots];
+  HandlerEntry handlers[MaxHandlers];
+  MaskEntry masks[MaxMasks];
+  uint8_t numHandlers;
+  uint8_t numMasks;
+  uint32_t unhandled;
+};
+
+#endif
@@ -0,0 +1,16 @@
+/*
+   Event capture persistence and serial dump
+   A frozen capture is too big for EEPROM, so the frames closest to the
+   trigger are kept, timestamps cut down to ms relative to the trigger.
+ */
+
+#ifndef CAPTURE_STORE_H
+#define CAPTURE_STORE_H
+
+#include "eventCapture.h"
+
+void saveCapture(const EventCapture &capture);
+void dumpCapture(const EventCapture &capture); // full RAM window
+void dumpSavedCapture(void);                   // whatever is in EEPROM
+
+#endif
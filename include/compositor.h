@@ -0,0 +1,44 @@
+/*
+   Layered display compositor
+   Each view draws into its own layer instead of owning the strip. Once per
+   render tick the layers are blended bottom to top into one frame, so a
+   warning can flash over the tach without the tach having to know.
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stdint.h>
+
+static const uint8_t numLeds = 16;
+
+struct Rgb {
+  uint8_t r, g, b;
+};
+
+struct Layer {
+  Rgb color[numLeds];
+  uint8_t alpha[numLeds]; // 0 is see-through, 255 fully covers what's below
+
+  void clear();
+  void set(int i, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
+  void fill(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
+};
+
+// bottom to top
+enum LayerId { LAYER_BASE, LAYER_SHIFT, LAYER_WARNING, NUM_LAYERS };
+
+class Compositor {
+public:
+  Compositor();
+
+  Layer &layer(LayerId id) { return layers[id]; }
+  void compose(); // blends every layer into frame
+  const Rgb *frame() const { return out; }
+
+private:
+  Layer layers[NUM_LAYERS];
+  Rgb out[numLeds];
+};
+
+#endif
@@ -0,0 +1,23 @@
+/*
+   CRC-16/CCITT-FALSE for anything written to EEPROM
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+inline uint16_t crc16(const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+#endif
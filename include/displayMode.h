@@ -0,0 +1,85 @@
+/*
+   Display mode state machine
+   What the strip shows is one explicit mode, changed only by the guarded
+   transitions in the table in displayMode.cpp. The rpm, tps and redline
+   thresholds have hysteresis, and the transitions a driver would see as
+   flicker also need the current mode to have lasted a minimum dwell time.
+   Losing the ECU and going over the redline are never held back.
+
+   Each update() checks the transitions out of the current mode in table
+   order, takes the first whose guard passes and runs the exit action of
+   the old mode and the entry action of the new one. One transition per
+   update, so the cost is bounded by the table size whatever the inputs.
+   Counters keep how often each transition fired and how often a dwell
+   held one back, which is the flapping that would otherwise have shown.
+ */
+
+#ifndef DISPLAY_MODE_H
+#define DISPLAY_MODE_H
+
+#include <stdint.h>
+
+enum DisplayMode {
+  MODE_WAKEUP,    // light show after power up
+  MODE_HEARTBEAT, // no ECU
+  MODE_BATTERY,   // ECU up, engine off
+  MODE_TPS,       // engine off, throttle opened
+  MODE_TACH,      // engine running
+  MODE_REDLINE,   // over the redline
+  NUM_MODES,
+  MODE_ANY = NUM_MODES // as a transition's from, every mode but the target
+};
+
+struct ModeInputs {
+  bool wakeupComplete;
+  bool ecuOnline;
+  int32_t rpm;
+  int32_t tps; // 0.1 %
+  int32_t redline;
+};
+
+// thresholds, rising / falling
+static const int32_t modeRunningRpm = 500;
+static const int32_t modeStoppedRpm = 400;
+static const int32_t modeTpsShow = 200;
+static const int32_t modeTpsHide = 150;
+static const int32_t modeRedlineDrop = 250; // under the redline to leave it
+
+struct ModeTransition {
+  uint8_t from; // DisplayMode or MODE_ANY
+  uint8_t to;
+  bool (*guard)(const ModeInputs &in);
+  uint16_t dwellMs; // time in from before this can fire
+};
+
+typedef void (*ModeAction)(DisplayMode from, DisplayMode to, uint32_t now);
+
+class ModeMachine {
+public:
+  ModeMachine();
+
+  void onEnter(DisplayMode mode, ModeAction action) { enter[mode] = action; }
+  void onExit(DisplayMode mode, ModeAction action) { exit[mode] = action; }
+
+  void update(const ModeInputs &in, uint32_t now);
+  void restartDwell(uint32_t now) { since = now; }
+
+  DisplayMode mode() const { return current; }
+  uint32_t timeInMode(uint32_t now) const { return now - since; }
+
+  uint32_t transitions(int from, int to) const { return fired[from][to]; }
+  uint32_t held() const { return heldBack; } // guards that passed too soon
+  void resetCounters();
+
+private:
+  DisplayMode current;
+  uint32_t since;
+  ModeAction enter[NUM_MODES];
+  ModeAction exit[NUM_MODES];
+  uint32_t fired[NUM_MODES][NUM_MODES];
+  uint32_t heldBack;
+};
+
+extern const char *const modeNames[NUM_MODES];
+
+#endif
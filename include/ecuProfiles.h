@@ -0,0 +1,246 @@
+/*
+   ECU protocol profiles
+   Each profile is a type with static members that turns that ECU's frames
+   into the common signal set in signals.h. The firmware picks one at compile
+   time (-DECU_PROFILE=HaltechProfile), and since everything is static and
+   inline the decode compiles down to the same compares and shifts as a
+   hand written decoder for that ECU.
+
+   A profile provides
+     defaultBaud                the rate the ECU normally runs at
+     subscribe(dispatch, fn)    registers fn for every frame it decodes
+     decode(id, buf, out)       calls out.set(signal, value) per channel
+
+   MoTeC ECUs can send several dash data sets, MotecProfile decodes the
+   fixed M800 Set 1 layout. The ECU's CAN data set has to be set to match.
+ */
+
+#ifndef ECU_PROFILES_H
+#define ECU_PROFILES_H
+
+#include <stdint.h>
+
+#include "signals.h"
+
+// little and big endian field helpers
+inline uint16_t le16(const uint8_t *buf, int i) {
+  return buf[i] | (buf[i + 1] << 8);
+}
+inline uint16_t be16(const uint8_t *buf, int i) {
+  return (buf[i] << 8) | buf[i + 1];
+}
+
+// -------------------------------------------------------------
+// PE3, AN400. 29 bit IDs, little endian
+struct Pe3Profile {
+  static const uint32_t defaultBaud = 250000;
+
+  static const uint32_t PE1 = 218099784; // rpm, tps, fuel time, ignition angle
+  static const uint32_t PE2 = 218100040; // barometer, MAP and lambda
+  static const uint32_t PE3 = 218100296; // analog inputs 1-4, 0.001 V
+  static const uint32_t PE6 = 218101064; // voltage, air temp, coolant temp
+
+  static int oilPressureInput; // PE3 analog input (0-3) the oil sender is on
+
+  template <typename D> static void subscribe(D &dispatch,
+                                              typename D::Handler fn) {
+    dispatch.subscribe(PE1, fn);
+    dispatch.subscribe(PE2, fn);
+    dispatch.subscribe(PE3, fn);
+    dispatch.subscribe(PE6, fn);
+  }
+
+  template <typename Out>
+  static void decode(uint32_t id, const uint8_t *buf, Out &out) {
+    switch (id) {
+    case PE1:
+      out.set(SIG_RPM, le16(buf, 0));
+      out.set(SIG_TPS, le16(buf, 2));
+      break;
+    case PE2:
+      out.set(SIG_LAMBDA, le16(buf, 4));
+      break;
+    case PE3:
+      out.set(SIG_OIL_PRESSURE, le16(buf, oilPressureInput * 2));
+      break;
+    case PE6: {
+      bool celsius = buf[6]; // ECU sends either unit
+      out.set(SIG_VOLTS, le16(buf, 0));
+      out.set(SIG_AIR_TEMP, toCelsius((int16_t)le16(buf, 2), celsius));
+      out.set(SIG_COOLANT_TEMP, toCelsius((int16_t)le16(buf, 4), celsius));
+      break;
+    }
+    }
+  }
+};
+
+// -------------------------------------------------------------
+// SAE J1939 engine PGNs. the PGN sits in the middle of the 29 bit ID with
+// priority above it and the sender's address below, so frames are matched
+// on the PGN bits only
+inline uint32_t j1939Pgn(uint32_t id) {
+  uint32_t pf = (id >> 16) & 0xFF;
+  uint32_t pgn = (id >> 8) & 0x3FFFF;
+  // PDU1 (pf < 240) carries a destination address where PS would be
+  return pf < 240 ? (pgn & 0x3FF00) : pgn;
+}
+
+struct J1939Profile {
+  static const uint32_t defaultBaud = 250000;
+
+  static const uint32_t EEC2 = 61443; // accelerator pedal
+  static const uint32_t EEC1 = 61444; // engine speed
+  static const uint32_t ET1 = 65262;  // coolant temp
+  static const uint32_t IC1 = 65270;  // intake manifold temp
+  static const uint32_t VEP1 = 65271; // battery potential
+
+  template <typename D> static void subscribe(D &dispatch,
+                                              typename D::Handler fn) {
+    // PF 0xF0 covers EEC1/EEC2, PF 0xFE the slower engine PGNs
+    dispatch.subscribeMask(0x00F00000, 0x03FF0000, fn);
+    dispatch.subscribeMask(0x00FE0000, 0x03FF0000, fn);
+  }
+
+  template <typename Out>
+  static void decode(uint32_t id, const uint8_t *buf, Out &out) {
+    switch (j1939Pgn(id)) {
+    case EEC1: // 0.125 rpm/bit
+      out.set(SIG_RPM, le16(buf, 3) >> 3);
+      break;
+    case EEC2: // 0.4 %/bit
+      out.set(SIG_TPS, buf[1] * 4);
+      break;
+    case ET1: // 1 C/bit, -40 C offset
+      out.set(SIG_COOLANT_TEMP, (buf[0] - 40) * 10);
+      break;
+    case IC1:
+      out.set(SIG_AIR_TEMP, (buf[2] - 40) * 10);
+      break;
+    case VEP1: // SPN 168 battery potential, bytes 5-6, 0.05 V/bit
+      out.set(SIG_VOLTS, le16(buf, 4) * 5);
+      break;
+    }
+  }
+};
+
+// -------------------------------------------------------------
+// Haltech broadcast protocol v2. 11 bit IDs, big endian
+struct HaltechProfile {
+  static const uint32_t defaultBaud = 1000000;
+
+  static const uint32_t ENGINE = 0x360; // rpm, MAP, tps
+  static const uint32_t LAMBDA = 0x368; // wideband 1, 0.001 lambda
+  static const uint32_t POWER = 0x372;  // battery, 0.1 V
+  static const uint32_t TEMPS = 0x3E0;  // coolant, air, 0.1 K
+
+  template <typename D> static void subscribe(D &dispatch,
+                                              typename D::Handler fn) {
+    dispatch.subscribe(ENGINE, fn);
+    dispatch.subscribe(LAMBDA, fn);
+    dispatch.subscribe(POWER, fn);
+    dispatch.subscribe(TEMPS, fn);
+  }
+
+  template <typename Out>
+  static void decode(uint32_t id, const uint8_t *buf, Out &out) {
+    switch (id) {
+    case ENGINE:
+      out.set(SIG_RPM, be16(buf, 0));
+      out.set(SIG_TPS, be16(buf, 4));
+      break;
+    case LAMBDA:
+      out.set(SIG_LAMBDA, be16(buf, 0) / 10);
+      break;
+    case POWER:
+      out.set(SIG_VOLTS, be16(buf, 0) * 10);
+      break;
+    case TEMPS:
+      out.set(SIG_COOLANT_TEMP, be16(buf, 0) - 2732);
+      out.set(SIG_AIR_TEMP, be16(buf, 2) - 2732);
+      break;
+    }
+  }
+};
+
+// -------------------------------------------------------------
+// AEM Infinity AEMnet. 29 bit IDs, big endian. only the engine frame has a
+// fixed scaling worth mapping, so no volts or lambda
+struct AemProfile {
+  static const uint32_t defaultBaud = 500000;
+
+  static const uint32_t ENGINE = 0x01F0A000; // rpm, load, tps, air, coolant
+
+  template <typename D> static void subscribe(D &dispatch,
+                                              typename D::Handler fn) {
+    dispatch.subscribe(ENGINE, fn);
+  }
+
+  template <typename Out>
+  static void decode(uint32_t id, const uint8_t *buf, Out &out) {
+    if (id == ENGINE) {
+      out.set(SIG_RPM, be16(buf, 0) * 25 >> 6);        // 0.39063 rpm/bit
+      out.set(SIG_TPS, be16(buf, 4) * 10 / 655);       // 0.0015259 %/bit
+      out.set(SIG_AIR_TEMP, (int8_t)buf[6] * 10);      // 1 C/bit
+      out.set(SIG_COOLANT_TEMP, (int8_t)buf[7] * 10);
+    }
+  }
+};
+
+// -------------------------------------------------------------
+// MoTeC M800 dash data Set 1. one 11 bit ID carries a compound message of
+// big endian words across consecutive frames. the first frame starts with
+// the 0x82 0x81 0x80 header and a length byte, so word n is at byte
+// 4 + 2n of the message. the first six words are rpm, tps, MAP, air temp,
+// engine temp (0.1 C) and lambda 1 (0.001 La), all but MAP are used. oil
+// is in kPa rather than a sender voltage, so it is left out like the volts
+// further down the set
+struct MotecProfile {
+  static const uint32_t defaultBaud = 1000000;
+
+  static const uint32_t DASH = 0x5F0; // the M800's default dash address
+
+  template <typename D> static void subscribe(D &dispatch,
+                                              typename D::Handler fn) {
+    dispatch.subscribe(DASH, fn);
+  }
+
+  // frames since the header. a dropped frame shifts the rest of that
+  // message, the next header puts it right
+  static uint8_t &frameIndex() {
+    static uint8_t index = 0xFF; // nothing until the first header
+    return index;
+  }
+
+  template <typename Out>
+  static void decode(uint32_t id, const uint8_t *buf, Out &out) {
+    if (id != DASH) {
+      return;
+    }
+    uint8_t &index = frameIndex();
+    if (buf[0] == 0x82 && buf[1] == 0x81 && buf[2] == 0x80) {
+      index = 0;
+    } else if (index != 0xFF) {
+      index++;
+    }
+
+    switch (index) {
+    case 0: // header, words 0-1
+      out.set(SIG_RPM, be16(buf, 4));
+      out.set(SIG_TPS, be16(buf, 6));
+      break;
+    case 1: // words 2-5
+      out.set(SIG_AIR_TEMP, (int16_t)be16(buf, 2));
+      out.set(SIG_COOLANT_TEMP, (int16_t)be16(buf, 4));
+      out.set(SIG_LAMBDA, be16(buf, 6) / 10);
+      break;
+    }
+  }
+};
+
+#ifndef ECU_PROFILE
+#define ECU_PROFILE Pe3Profile
+#endif
+
+typedef ECU_PROFILE EcuProfile;
+
+#endif
@@ -0,0 +1,19 @@
+/*
+   EEPROM map
+   The Teensy 3.1/3.2 has 2048 bytes of emulated EEPROM, split up here so
+   nothing that persists can step on anything else.
+ */
+
+#ifndef EEPROM_LAYOUT_H
+#define EEPROM_LAYOUT_H
+
+static const int eepromCaptureStart = 0;
+static const int eepromCaptureSize = 1280;
+
+static const int eepromStatsStart = 1280;
+static const int eepromStatsSize = 512;
+
+static const int eepromCalStart = 1792;
+static const int eepromCalSize = 256;
+
+#endif
@@ -0,0 +1,65 @@
+/*
+   Pre-trigger event capture
+   Every frame goes into a fixed RAM ring. When something goes wrong (an
+   over-rev, the ECU dropping off) the ring keeps running for a short post
+   trigger window and then freezes, so what led up to the event and what
+   followed it are both kept until someone reads them out.
+ */
+
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <stdint.h>
+
+struct CapturedFrame {
+  uint32_t micros;
+  uint32_t id;
+  uint8_t len;
+  uint8_t buf[8];
+};
+
+enum CaptureTrigger {
+  TRIGGER_OVERREV = 1 << 0,
+  TRIGGER_ECU_LOST = 1 << 1,
+  TRIGGER_MANUAL = 1 << 2,
+};
+
+enum CaptureState { CAPTURE_ARMED, CAPTURE_TRIGGERED, CAPTURE_FROZEN };
+
+class EventCapture {
+public:
+  static const int size = 512; // frames, must be a power of two
+  static const int postFrames = 128;
+  static const uint32_t postMicros = 1000000; // freeze anyway after this
+
+  EventCapture();
+
+  // called for every frame from the CAN callback, a copy and an increment
+  void record(uint32_t micros, uint32_t id, uint8_t len, const uint8_t *buf);
+
+  // false if a capture is already in progress or frozen
+  bool trigger(uint8_t reason, uint32_t micros);
+
+  // freezes if the post trigger window timed out before it filled
+  void poll(uint32_t micros);
+  void rearm();
+
+  CaptureState state() const { return (CaptureState)status; }
+  uint8_t reason() const { return triggerReason; }
+  uint32_t triggerTime() const { return triggerMicros; }
+
+  // frozen window, oldest first
+  int count() const;
+  const CapturedFrame &frame(int i) const;
+  int triggerFrame() const; // index of the first frame after the trigger
+
+private:
+  CapturedFrame ring[size];
+  volatile uint32_t head; // total frames recorded, wraps
+  volatile uint8_t status;
+  uint8_t triggerReason;
+  uint32_t triggerHead;
+  uint32_t triggerMicros;
+};
+
+#endif
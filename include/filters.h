@@ -0,0 +1,42 @@
+/*
+   Signal conditioning
+   Each decoded channel can run through a median of up to five samples to
+   throw out single bad values, then a first order IIR low pass, then a
+   rate limit. Everything is integer with the state held in the channel, so
+   a sample costs the same every time: at most ten compares for the median
+   and a couple of multiplies.
+
+   Latency at the channel's update rate: a median of N holds a step back by
+   (N - 1) / 2 samples, and the IIR reaches 90 % of a step after about
+   2.3 * 256 / alpha samples.
+ */
+
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <stdint.h>
+
+struct FilterConfig {
+  uint8_t median;    // samples, 1 is off, otherwise 3 or 5
+  uint16_t iirAlpha; // weight of each new sample in 1/256, 256 is off
+  int32_t maxRate;   // units per second, 0 is off
+};
+
+struct FilterState {
+  static const int maxMedian = 5;
+
+  int32_t window[maxMedian]; // the last median samples
+  uint8_t filled;
+  uint8_t next;
+  bool primed;
+  int32_t iir; // value << 8
+  int32_t out;
+  uint32_t lastMs;
+};
+
+#define FILTER_OFF {1, 256, 0}
+
+int32_t filterSample(const FilterConfig &config, FilterState &state,
+                     int32_t x, uint32_t now);
+
+#endif
@@ -0,0 +1,74 @@
+/*
+   Display layout
+   A zone is a run of leds on one strip that a view draws into by its own
+   index, 0 at the zone's start. Which strip, where on it and which way it
+   runs are template parameters, so Zone::set() compiles down to a store
+   at a constant offset into that strip's buffer and a second display
+   costs nothing per frame beyond the pixels it draws.
+
+     Zone<S, strip, offset, length, reversed>   leds offset.. of strip
+     JoinedZone<A, B>                           A then B as one zone, e.g.
+                                                a bar split over two strips
+     NoZone                                     not fitted, draws nothing
+
+   The layout itself is a handful of typedefs at the top of main.cpp.
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+
+#include "compositor.h"
+
+template <typename S, S &strip, int Offset, int Length, bool Reversed = false>
+struct Zone {
+  static const int length = Length;
+  static_assert(Offset >= 0 && Offset + Length <= S::length,
+                "zone runs off the end of its strip");
+
+  static void set(int i, uint8_t r, uint8_t g, uint8_t b) {
+    strip.setPixelColor(Reversed ? Offset + Length - 1 - i : Offset + i, r, g,
+                        b);
+  }
+  static void fill(uint8_t r, uint8_t g, uint8_t b) {
+    for (int i = 0; i < Length; i++) {
+      set(i, r, g, b);
+    }
+  }
+  static void copy(const Rgb *src) {
+    for (int i = 0; i < Length; i++) {
+      set(i, src[i].r, src[i].g, src[i].b);
+    }
+  }
+};
+
+template <typename A, typename B> struct JoinedZone {
+  static const int length = A::length + B::length;
+
+  static void set(int i, uint8_t r, uint8_t g, uint8_t b) {
+    if (i < A::length) {
+      A::set(i, r, g, b);
+    } else {
+      B::set(i - A::length, r, g, b);
+    }
+  }
+  static void fill(uint8_t r, uint8_t g, uint8_t b) {
+    A::fill(r, g, b);
+    B::fill(r, g, b);
+  }
+  static void copy(const Rgb *src) {
+    A::copy(src);
+    B::copy(src + A::length);
+  }
+};
+
+struct NoZone {
+  static const int length = 0;
+
+  static void set(int, uint8_t, uint8_t, uint8_t) {}
+  static void fill(uint8_t, uint8_t, uint8_t) {}
+  static void copy(const Rgb *) {}
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+   LED strip output
+   The strip is a statically sized pixel buffer plus a driver that clocks
+   it out. Length, colour order and driver are template parameters, so the
+   buffer is a fixed array sized at compile time (no heap, it shows up in
+   .bss at link time), loops over the strip have a constant bound and
+   there is no virtual call or runtime switch on the show() path. The
+   driver is picked with -DLED_DRIVER=Apa102Driver, the same way as the ECU
+   profile.
+
+   A driver provides
+     order                 the colour order the chip expects
+     globalBrightness      true if the chip dims in hardware
+     frameBytes(leds)      scratch the driver needs to send that many leds,
+                           the strip holds it so it always fits
+     begin(pin)            sets up the pin or peripheral
+     write(pin, bytes, leds, bright, frame)
+                           sends one frame, bytes in chip order
+
+   Ws2812Driver   WS2812 bit banged on any pin, timed off the cycle
+                  counter, so each strip can have its own. the 800 kHz
+                  timing needs interrupts off, about 30 us per led, so 16
+                  leds hold off CAN for ~0.5 ms
+   Apa102Driver   APA102/SK9822 on hardware SPI at 8 MHz, data on 11 and
+                  clock on pin 13 or 14, so only one strip. interrupts stay
+                  on and 16 leds take ~75 us. brightness goes to the 5 bit
+                  global current field so colours keep all 8 bits
+
+   The Adafruit NeoPixel library is no longer used or needed. It kept its
+   pixels on the heap, so WS2812 strips go through Ws2812Driver above.
+ */
+
+#ifndef LED_STRIP_H
+#define LED_STRIP_H
+
+#include <stdint.h>
+#include <string.h>
+
+enum ColorOrder { ORDER_RGB, ORDER_GRB, ORDER_BGR };
+
+// byte offsets of r, g and b within a pixel
+template <ColorOrder Order> struct ColorOffsets;
+template <> struct ColorOffsets<ORDER_RGB> {
+  static const int r = 0, g = 1, b = 2;
+};
+template <> struct ColorOffsets<ORDER_GRB> {
+  static const int r = 1, g = 0, b = 2;
+};
+template <> struct ColorOffsets<ORDER_BGR> {
+  static const int r = 2, g = 1, b = 0;
+};
+
+struct Ws2812Driver {
+  static const ColorOrder order = ORDER_GRB;
+  static const bool globalBrightness = false;
+
+  // sends straight from the pixels
+  static constexpr int frameBytes(int) { return 0; }
+
+  static void begin(uint8_t pin);
+  static void write(uint8_t pin, const uint8_t *bytes, int leds,
+                    uint8_t brightness, uint8_t *frame);
+};
+
+struct Apa102Driver {
+  static const ColorOrder order = ORDER_BGR;
+  static const bool globalBrightness = true;
+  static const uint32_t clockHz = 8000000;
+
+  // 32 bit start frame, 4 bytes per led and the end frame
+  static constexpr int endBytes(int leds) { return 4 + (leds + 15) / 16; }
+  static constexpr int frameBytes(int leds) {
+    return 4 + leds * 4 + endBytes(leds);
+  }
+
+  static void begin(uint8_t pin);
+  static void write(uint8_t pin, const uint8_t *bytes, int leds,
+                    uint8_t brightness, uint8_t *frame);
+};
+
+// driver scratch, nothing at all for a driver that needs none
+template <int Bytes> struct DriverFrame {
+  uint8_t bytes[Bytes];
+  uint8_t *data() { return bytes; }
+};
+template <> struct DriverFrame<0> {
+  uint8_t *data() { return 0; }
+};
+
+#ifndef LED_DRIVER
+#define LED_DRIVER Ws2812Driver
+#endif
+
+template <typename Driver, int Length, ColorOrder Order = Driver::order>
+class LedStrip {
+public:
+  static const int length = Length;
+  static const int bytes = Length * 3;
+
+  LedStrip() : pin(0), brightness(255) { clear(); }
+
+  void begin(uint8_t p) {
+    pin = p;
+    Driver::begin(pin);
+  }
+
+  // without hardware dimming pixels are scaled as they're set, so set the
+  // brightness before drawing
+  void setBrightness(uint8_t b) { brightness = b; }
+
+  void clear() { memset(pixels, 0, sizeof(pixels)); }
+  void setPixelColor(int i, uint8_t r, uint8_t g, uint8_t b) {
+    if (i < 0 || i >= Length) {
+      return;
+    }
+    if (!Driver::globalBrightness) {
+      r = (r * (brightness + 1)) >> 8; // exact at 255
+      g = (g * (brightness + 1)) >> 8;
+      b = (b * (brightness + 1)) >> 8;
+    }
+    uint8_t *p = pixels + i * 3;
+    p[ColorOffsets<Order>::r] = r;
+    p[ColorOffsets<Order>::g] = g;
+    p[ColorOffsets<Order>::b] = b;
+  }
+  static int numPixels() { return Length; }
+
+  void show() {
+    Driver::write(pin, pixels, Length, brightness, frame.data());
+  }
+
+private:
+  uint8_t pixels[bytes];
+  DriverFrame<Driver::frameBytes(Length)> frame;
+  uint8_t pin;
+  uint8_t brightness;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+   Compile time logging
+   Every log call has a level and a category. Anything below LOG_LEVEL or
+   outside LOG_CATEGORIES is a constant false branch the compiler throws
+   away, arguments and all, so production builds carry no debug output.
+   Enabled messages only format when they actually print, and each call
+   site prints at most once per LOG_RATE_MS unless given its own interval.
+
+   Set from platformio.ini, e.g.
+     build_flags = -DLOG_LEVEL=LOG_LEVEL_TRACE -DLOG_CATEGORIES=LOG_CAN
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_TRACE 5 // every CAN frame, what the capture tools read
+
+#define LOG_SYS 0x01     // startup, idle
+#define LOG_CAN 0x02     // bus rate, raw frames
+#define LOG_ECU 0x04     // decoded values, ECU on/offline
+#define LOG_SCHED 0x08   // scheduler and render timing
+#define LOG_CAPTURE 0x10 // event capture
+#define LOG_ALL 0xFF
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES LOG_ALL
+#endif
+
+#ifndef LOG_RATE_MS
+#define LOG_RATE_MS 1000
+#endif
+
+// usable in #if as well as in code
+#define LOG_ENABLED(level, cat)                                                \
+  ((level) <= LOG_LEVEL && ((cat) & (LOG_CATEGORIES)) != 0)
+
+// everyMs of 0 never drops a message
+#define LOG_EVERY(everyMs, level, cat, ...)                                    \
+  do {                                                                         \
+    if (LOG_ENABLED(level, cat)) {                                             \
+      static uint32_t logLast = 0;                                             \
+      static bool logStarted = false;                                          \
+      uint32_t logNow = millis();                                              \
+      uint32_t logEvery = (everyMs); /* 0 compares without -Wtype-limits */    \
+      if (logEvery == 0 || !logStarted || logNow - logLast >= logEvery) {      \
+        logStarted = true;                                                     \
+        logLast = logNow;                                                      \
+        Serial.printf(__VA_ARGS__);                                            \
+        Serial.println();                                                      \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+
+#define LOG_ERROR(cat, ...)                                                    \
+  LOG_EVERY(LOG_RATE_MS, LOG_LEVEL_ERROR, cat, __VA_ARGS__)
+#define LOG_WARN(cat, ...)                                                     \
+  LOG_EVERY(LOG_RATE_MS, LOG_LEVEL_WARN, cat, __VA_ARGS__)
+#define LOG_INFO(cat, ...)                                                     \
+  LOG_EVERY(LOG_RATE_MS, LOG_LEVEL_INFO, cat, __VA_ARGS__)
+#define LOG_DEBUG(cat, ...)                                                    \
+  LOG_EVERY(LOG_RATE_MS, LOG_LEVEL_DEBUG, cat, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,56 @@
+/*
+   Cooperative deadline scheduler
+   Tasks are plain functions with a period, a deadline and a priority. Each
+   call to runOnce() runs the highest priority task that is due and keeps
+   count of how late it started (jitter) and whether it finished past its
+   deadline (overrun). Nothing is preempted, a task runs to completion.
+
+   Time comes from a clock function so the scheduler can run against
+   micros() on the Teensy or a fake clock on a host.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+struct Task {
+  const char *name;
+  void (*run)(uint32_t now); // now in clock ticks (us)
+  uint32_t period;
+  uint32_t deadline; // from release, 0 means the same as period
+  uint8_t priority;  // higher runs first when several are due
+
+  // filled in by the scheduler
+  uint32_t nextRelease;
+  uint32_t runs;
+  uint32_t overruns;
+  uint32_t skipped; // whole periods missed
+  uint32_t maxJitter;
+  uint32_t maxRun;
+};
+
+#define TASK(name, fn, period, deadline, priority)                             \
+  {name, fn, period, deadline, priority, 0, 0, 0, 0, 0, 0}
+
+class Scheduler {
+public:
+  static const int maxTasks = 12;
+
+  explicit Scheduler(uint32_t (*clock)(void));
+
+  bool add(Task &task); // false if the table is full
+  bool runOnce();       // false if nothing was due
+  void resync();        // restart every period from now, e.g. after sleeping
+  void resetStats();
+
+  int count() const { return numTasks; }
+  const Task &task(int i) const { return *tasks[i]; }
+
+private:
+  uint32_t (*clock)(void);
+  Task *tasks[maxTasks];
+  int numTasks;
+};
+
+#endif
@@ -0,0 +1,52 @@
+/*
+   Single writer sequence lock
+   The writer (the CAN interrupt) bumps the sequence to odd, copies the value
+   in and bumps it back to even. The reader (loop) copies the value out and
+   retries if the sequence was odd or moved underneath it, so it always gets
+   one consistent snapshot without masking interrupts.
+
+   Only valid when the writer can preempt the reader and not the other way
+   round, which is the case for an ISR and loop() on a single core.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+
+// stops the compiler moving loads/stores across it, the M4 is single core
+// so no hardware barrier is needed
+#define COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+template <typename T> class Seqlock {
+public:
+  Seqlock() : seq(0), data() {}
+
+  void write(const T &value) {
+    seq = seq + 1;
+    COMPILER_BARRIER();
+    data = value;
+    COMPILER_BARRIER();
+    seq = seq + 1;
+  }
+
+  T read() const {
+    T copy;
+    uint32_t start;
+    do {
+      start = seq;
+      COMPILER_BARRIER();
+      copy = data;
+      COMPILER_BARRIER();
+    } while ((start & 1) || start != seq);
+    return copy;
+  }
+
+  uint32_t writes() const { return seq >> 1; }
+
+private:
+  volatile uint32_t seq;
+  T data;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/*
+   Engine usage statistics
+   Accumulated from every rpm and voltage update at a fixed cost per frame,
+   and kept in small integer bins so the whole lot fits in one EEPROM slot.
+ */
+
+#ifndef SESSION_STATS_H
+#define SESSION_STATS_H
+
+#include <stdint.h>
+
+enum RpmZone { ZONE_OFF, ZONE_NORMAL, ZONE_SHIFT, ZONE_OVERREV, NUM_ZONES };
+
+struct SessionStats {
+  static const int rpmBins = 24;   // 500 rpm each, the last bin is open ended
+  static const int rpmPerBin = 500;
+  static const uint16_t maxGapMs = 100; // longer gaps are lost frames, not time
+
+  uint32_t rpmMs[rpmBins];    // time spent in each rpm bin
+  uint32_t zoneMs[NUM_ZONES]; // time spent in each display zone
+  uint16_t peakRpm;
+  uint16_t overRevs; // times the rpm has gone past redline
+  uint16_t minVolts; // 0.01 V
+  uint16_t maxVolts;
+  uint16_t sessions; // power ups since the stats were last cleared
+
+  // private to the accumulator, not persisted meaningfully
+  uint32_t lastRpmMillis;
+  bool overRev;
+
+  void clear();
+  void onRpm(int32_t rpm, uint32_t now, int shiftRpm, int redline);
+  void onVolts(int32_t volts);
+};
+
+#endif
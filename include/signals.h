@@ -0,0 +1,53 @@
+/*
+   Decoded signal store
+   Every channel pulled off the bus keeps its last value, when it arrived and
+   how often it should arrive, so the display can tell live data from data
+   that stopped updating.
+ */
+
+#ifndef SIGNALS_H
+#define SIGNALS_H
+
+#include <stdint.h>
+
+#include "filters.h"
+
+enum SignalId {
+  SIG_RPM,          // 1 rpm
+  SIG_TPS,          // 0.1 %
+  SIG_VOLTS,        // 0.01 V
+  SIG_AIR_TEMP,     // 0.1 C
+  SIG_COOLANT_TEMP, // 0.1 C
+  SIG_LAMBDA,       // 0.01 lambda
+  SIG_OIL_PRESSURE, // 1 mV on the oil pressure sender input
+  NUM_SIGNALS
+};
+
+// value, lastUpdate, valid and filterState are written only by the CAN
+// callback, stale and staleEvents only by checkStale() in loop(). the one
+// exception is checkStale() clearing filterState, with interrupts off, when
+// a channel goes stale. value and lastUpdate are single aligned words so
+// neither can tear, but they may be one update apart
+struct Signal {
+  volatile int32_t value;       // scaled value, units above, filtered
+  volatile uint32_t lastUpdate; // millis() of the last update
+  uint16_t periodMs;            // expected update period
+  volatile bool valid;          // has been updated at least once
+  bool stale;                   // missed too many periods
+  uint16_t staleEvents;         // times the signal has gone stale
+  FilterConfig filter;
+  FilterState filterState;
+};
+
+extern Signal signals[NUM_SIGNALS];
+
+void updateSignal(SignalId id, int32_t raw, uint32_t now); // filters raw
+void checkStale(uint32_t now); // call at least every few ms
+bool signalFresh(SignalId id);
+
+// PE3 temps are 0.1 deg in whichever unit the ECU is set to, keep them in C
+inline int32_t toCelsius(int16_t raw, bool celsius) {
+  return celsius ? raw : (raw - 320) * 5 / 9;
+}
+
+#endif
@@ -0,0 +1,16 @@
+/*
+   Session statistics persistence and serial export
+   Checkpoints rotate through several EEPROM slots so no one slot takes
+   every write. The slot with the newest valid sequence number wins.
+ */
+
+#ifndef STATS_STORE_H
+#define STATS_STORE_H
+
+#include "sessionStats.h"
+
+bool loadStats(SessionStats &stats); // false if nothing valid was saved
+void saveStats(const SessionStats &stats);
+void printStats(const SessionStats &stats);
+
+#endif
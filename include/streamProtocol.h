@@ -0,0 +1,65 @@
+/*
+   Binary channel stream over USB serial
+   Shared by the firmware and the host receiver in tools/dashrx, so both
+   sides always agree on the layout. Everything is little endian, which is
+   what both the Teensy and x86/ARM hosts are.
+
+   A packet is one header, samplesPerPacket samples taken streamPeriod us
+   apart starting at header.micros, then a CRC-16 over everything before it.
+   A 12 byte header, 3 samples of 16 bytes and the CRC make 62 bytes, so a
+   packet fits one 64 byte USB packet.
+ */
+
+#ifndef STREAM_PROTOCOL_H
+#define STREAM_PROTOCOL_H
+
+#include <stdint.h>
+
+#include "crc16.h"
+
+static const uint8_t streamSync0 = 0xA5;
+static const uint8_t streamSync1 = 0x5A;
+static const uint8_t streamVersion = 1;
+static const int samplesPerPacket = 3;
+
+enum StreamFlags {
+  STREAM_ECU_ONLINE = 1 << 0,
+  STREAM_ENG_RUNNING = 1 << 1,
+  STREAM_SHOWING_TPS = 1 << 2,
+  STREAM_WARNING = 1 << 3,
+};
+
+struct StreamHeader {
+  uint8_t sync0, sync1;
+  uint8_t version;
+  uint8_t count;   // samples in this packet
+  uint16_t seq;    // per packet, a jump means packets were lost
+  uint16_t period; // us between samples
+  uint32_t micros; // device time of the first sample
+} __attribute__((packed));
+
+struct StreamSample {
+  uint16_t rpm;     // 1 rpm
+  uint16_t tps;     // 0.1 %
+  uint16_t volts;   // 0.01 V
+  int16_t air;      // 0.1 C
+  int16_t coolant;  // 0.1 C
+  uint16_t lambda;  // 0.01
+  uint16_t oil;     // mV
+  uint8_t flags;    // StreamFlags
+  uint8_t stale;    // bit per SignalId
+} __attribute__((packed));
+
+struct StreamPacket {
+  StreamHeader header;
+  StreamSample samples[samplesPerPacket];
+  uint16_t crc;
+} __attribute__((packed));
+
+static_assert(sizeof(StreamPacket) <= 64, "one USB packet per StreamPacket");
+
+inline uint16_t streamCrc(const StreamPacket &p) {
+  return crc16(&p, sizeof(p) - sizeof(p.crc));
+}
+
+#endif
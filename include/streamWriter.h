@@ -0,0 +1,37 @@
+/*
+   Binary channel stream, the firmware side
+   Collects samples into StreamPackets (see streamProtocol.h) and seals each
+   one with its sequence number and CRC once it is full. Sending is left to
+   the caller, so the packing runs the same on the Teensy and in the host
+   tests.
+ */
+
+#ifndef STREAM_WRITER_H
+#define STREAM_WRITER_H
+
+#include <stdint.h>
+
+#include "streamProtocol.h"
+
+class StreamWriter {
+public:
+  StreamWriter() : fill(0), seq(0) {}
+
+  // adds a sample taken at now, period us after the one before. returns
+  // true when that completed a packet, which stays in packet() until the
+  // next add()
+  bool add(const StreamSample &sample, uint32_t now, uint16_t period);
+  const StreamPacket &packet() const { return out; }
+
+  void restart() { fill = 0; } // drops a part filled packet
+
+private:
+  StreamPacket out;
+  int fill;
+  uint16_t seq;
+};
+
+// the decoded channels and staleness from the signal store
+void sampleSignals(StreamSample &sample, uint8_t flags);
+
+#endif
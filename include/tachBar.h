@@ -0,0 +1,31 @@
+/*
+   Sub-LED tach bar position
+   Works out how far up the strip the bar reaches in 1/256ths of an LED, so
+   the leading LED can fade in instead of snapping on every ~600 rpm.
+ */
+
+#ifndef TACH_BAR_H
+#define TACH_BAR_H
+
+#include <stdint.h>
+
+struct TachBar {
+  uint8_t fullLeds;  // leds 0 to fullLeds - 1 are fully on
+  uint8_t leadLevel; // brightness of led fullLeds, gamma corrected
+};
+
+extern const uint8_t gamma8[256];
+
+// smooth = false reproduces the old whole-pixel bar exactly
+TachBar tachBarPosition(int rpm, int rpmPerLED, int numLEDs, bool smooth);
+
+// leds lit by the throttle bar for tps in 0.1 %, rounded up like the old
+// ceil(map(tp, 0, 100, 0, numLEDs)) on a double, clamped to the strip
+int tpsBarLeds(int tps, int numLEDs);
+
+// scales one colour channel by a 0-255 level, 255 leaves it untouched
+inline uint8_t scaleChannel(uint8_t c, uint8_t level) {
+  return (uint8_t)((c * (level + 1)) >> 8);
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+   Threshold warning engine
+   Each rule watches one decoded signal with separate raise and clear
+   thresholds (hysteresis) and a minimum time past the raise threshold, so a
+   value sitting on the boundary can't make the warning flicker.
+ */
+
+#ifndef WARNINGS_H
+#define WARNINGS_H
+
+#include <stdint.h>
+
+#include "signals.h"
+
+struct WarningRule {
+  SignalId signal;
+  int8_t sign;       // 1 warns above raise, -1 warns below it
+  int32_t raise;     // sets the warning once past this for minMs
+  int32_t clear;     // clears it once back past this
+  uint16_t minMs;    // how long past raise before it sets
+  bool runningOnly;  // only meaningful with the engine running
+  uint8_t priority;  // higher wins the warning layer
+  uint8_t r, g, b;   // flash colour
+};
+
+struct WarningState {
+  bool active;
+  bool pending;   // past raise, waiting out minMs
+  uint32_t since; // when it went past raise
+  uint16_t events; // times the warning has been raised
+};
+
+enum WarningId {
+  WARN_OIL_PRESSURE,
+  WARN_COOLANT_HOT,
+  WARN_VOLTS_LOW,
+  WARN_LAMBDA_LEAN,
+  WARN_AIR_HOT,
+  NUM_WARNINGS
+};
+
+extern WarningRule warningRules[NUM_WARNINGS];
+extern WarningState warningStates[NUM_WARNINGS];
+
+// walks the whole table every call, so the cost doesn't depend on the data
+void evaluateWarnings(bool engRunning, uint32_t now);
+
+// highest priority active warning, or -1
+int topWarning(void);
+
+#endif
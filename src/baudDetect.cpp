@@ -0,0 +1,206 @@
+/*
+   Listen-only CAN bit rate detection
+   Each candidate rate gets a short window in listen-only mode (CTRL1_LOM).
+   Valid frames count for a rate, error flags latched in ESR1 count against
+   it. The first rate with enough frames and no errors wins.
+
+   Without a lock in setup() the sweep carries on from a task, one window
+   per call, so an ECU that boots after the dash is still found whatever
+   its rate. Between passes it waits at the fallback rate, twice as long
+   each time up to 30 s, and a clean window there joins as well.
+
+   Can0.begin() leaves the controller active and only then can LOM be set,
+   so while the rate is unknown begin() routes TX to the alternate pin 32,
+   an unconnected pad on the Teensy 3.2, and pin 3 is held recessive as a
+   plain GPIO. Nothing the controller drives before LOM takes effect can
+   reach the transceiver.
+ */
+
+#include "baudDetect.h"
+
+#include <Arduino.h>
+#include <FlexCAN.h>
+
+static const uint32_t candidateBauds[] = {250000, 500000, 1000000, 125000};
+static const int numCandidates =
+    sizeof(candidateBauds) / sizeof(candidateBauds[0]);
+
+static const uint32_t windowMs = baudRetryMs; // PE3 sends PE1 at 50Hz, ~5
+static const uint32_t budgetMs = 800; // lightShow takes ~2.5s, stay well under
+static const uint16_t minFrames = 3;
+static const uint32_t firstBackoffMs = 1000;
+static const uint32_t maxBackoffMs = 30000;
+
+static const uint8_t canTxPin = 3;     // to the transceiver
+static const uint8_t canTxAltPin = 32; // unconnected, TX parks here
+
+// error flags that mean we are sampling at the wrong rate. ACK_ERR is left
+// out since we never transmit while listening
+static const uint32_t rateErrorFlags =
+    FLEXCAN_ESR_STF_ERR | FLEXCAN_ESR_FRM_ERR | FLEXCAN_ESR_CRC_ERR |
+    FLEXCAN_ESR_BIT0_ERR | FLEXCAN_ESR_BIT1_ERR;
+
+// CTRL1 and the pin routing are only changed in freeze mode
+static void freeze(void) {
+  FLEXCAN0_MCR |= FLEXCAN_MCR_FRZ | FLEXCAN_MCR_HALT;
+  while (!(FLEXCAN0_MCR & FLEXCAN_MCR_FRZ_ACK))
+    ;
+}
+
+static void thaw(void) {
+  FLEXCAN0_MCR &= ~FLEXCAN_MCR_HALT;
+  while (FLEXCAN0_MCR & FLEXCAN_MCR_FRZ_ACK)
+    ;
+  while (FLEXCAN0_MCR & FLEXCAN_MCR_NOT_RDY)
+    ;
+}
+
+static bool canStarted = false;
+
+static void restartCan(uint32_t baud, uint8_t txAlt) {
+  // the module isn't clocked until the first begin(), so only halt it after
+  if (canStarted) {
+    Can0.end();
+  }
+  CAN_filter_t acceptAll;
+  acceptAll.rtr = 0;
+  acceptAll.ext = 0;
+  acceptAll.id = 0;
+  Can0.begin(baud, acceptAll, txAlt, 0);
+  canStarted = true;
+
+  // the other mailboxes take extended IDs, as setup() leaves them
+  CAN_filter_t extended = acceptAll;
+  extended.ext = 1;
+  for (uint8_t n = 1; n < 16; n++) {
+    Can0.setFilter(extended, n);
+  }
+}
+
+static uint32_t listeningBaud;
+
+static void startListening(uint32_t baud) {
+  listeningBaud = baud;
+  pinMode(canTxPin, OUTPUT);
+  digitalWrite(canTxPin, HIGH); // recessive
+  restartCan(baud, 1);
+
+  freeze();
+  FLEXCAN0_CTRL1 |= FLEXCAN_CTRL_LOM;
+  thaw();
+  (void)FLEXCAN0_ESR1; // error flags clear on read, drop anything stale
+}
+
+void joinBus(void) {
+  freeze();
+  CORE_PIN3_CONFIG = PORT_PCR_MUX(2); // CAN0_TX back on the transceiver
+  pinMode(canTxAltPin, INPUT);
+  FLEXCAN0_CTRL1 &= ~FLEXCAN_CTRL_LOM;
+  thaw();
+}
+
+// listens for one window, returns true if the rate looks clean
+static bool scoreWindow(uint16_t &frames, uint16_t &errors) {
+  CAN_message_t frame;
+  frame.timeout = 0;
+  frames = 0;
+  errors = 0;
+
+  uint32_t start = millis();
+  while (millis() - start < windowMs) {
+    while (Can0.read(frame)) {
+      frames++;
+    }
+    if (FLEXCAN0_ESR1 & rateErrorFlags) {
+      errors++;
+      // wrong rates produce errors on nearly every frame, no point waiting
+      if (errors > frames) {
+        return false;
+      }
+    }
+  }
+
+  return frames >= minFrames && errors == 0;
+}
+
+// retry state, for when detectBaud() didn't lock
+static int retryIndex = -1; // candidate being scored, -1 waiting at fallback
+static uint32_t retryFallback;
+static uint32_t retryResume; // millis() the next pass starts
+static uint32_t retryBackoffMs = firstBackoffMs;
+
+BaudDetectResult detectBaud(uint32_t fallbackBaud) {
+  BaudDetectResult result;
+  result.baud = fallbackBaud;
+  result.locked = false;
+  result.listenOnly = false;
+  result.frames = 0;
+  result.errors = 0;
+
+  uint32_t start = millis();
+  bool sawTraffic = false;
+
+  for (int i = 0; millis() - start < budgetMs; i = (i + 1) % numCandidates) {
+    uint16_t frames, errors;
+    startListening(candidateBauds[i]);
+    bool clean = scoreWindow(frames, errors);
+
+    result.errors += errors;
+    if (frames || errors) {
+      sawTraffic = true;
+    }
+
+    if (clean) {
+      result.baud = candidateBauds[i];
+      result.locked = true;
+      result.frames = frames;
+      break;
+    }
+  }
+
+  result.lockMillis = millis() - start;
+
+  if (result.locked) {
+    restartCan(result.baud, 0);
+    pinMode(canTxAltPin, INPUT);
+  } else {
+    // a silent bus may just be an ECU that boots slower than the sweep, a
+    // noisy one runs at a rate we can't match. either way keep listening
+    // at the fallback until frames decode there
+    startListening(result.baud);
+    result.listenOnly = true;
+
+    retryIndex = -1;
+    retryFallback = fallbackBaud;
+    retryBackoffMs = firstBackoffMs;
+    retryResume = millis() + retryBackoffMs;
+  }
+  result.sawTraffic = sawTraffic;
+
+  return result;
+}
+
+bool retryBaud(uint16_t frames, uint32_t now, uint32_t &baud) {
+  bool errors = FLEXCAN0_ESR1 & rateErrorFlags;
+  if (frames >= minFrames && !errors) {
+    baud = listeningBaud;
+    return true;
+  }
+
+  if (retryIndex < 0) {
+    if ((int32_t)(now - retryResume) < 0) {
+      return false;
+    }
+    retryIndex = 0;
+  } else if (++retryIndex == numCandidates) {
+    // a full pass and nothing clean, back to the fallback for a while
+    retryIndex = -1;
+    retryResume = now + retryBackoffMs;
+    retryBackoffMs = retryBackoffMs * 2 > maxBackoffMs ? maxBackoffMs
+                                                       : retryBackoffMs * 2;
+    startListening(retryFallback);
+    return false;
+  }
+  startListening(candidateBauds[retryIndex]);
+  return false;
+}
@@ -0,0 +1,84 @@
+/*
+   CAN bus statistics
+   Frame lengths are from the CAN 2.0 frame format, counting the 3 bit
+   interframe space. Stuff bits are bounded by the usual worst case of one
+   every four bits across the stuffed part of the frame.
+   Interval and jitter are exponential averages with a 1/8 weight.
+ */
+
+#include "busStats.h"
+
+#include <string.h>
+
+BusStats::BusStats(uint32_t baud)
+    : bitRate(baud), windowStart(0), bits(0), stuffBits(0),
+      untrackedFrames(0), lastBits(0), lastStuffBits(0), lastUntracked(0) {
+  memset(ids, 0, sizeof(ids));
+}
+
+void BusStats::update(uint32_t id, bool ext, uint8_t len, uint32_t now) {
+  roll(now);
+
+  // 47/67 bits fixed, of which 34/54 are subject to stuffing
+  uint32_t data = len * 8;
+  bits += (ext ? 67 : 47) + data;
+  stuffBits += ((ext ? 54 : 34) + data - 1) / 4;
+
+  // top bits of the product, the low ones only see the low bits of the id
+  uint32_t start = (id * 2654435761u) >> (32 - idBits);
+  for (int n = 0; n < maxIds; n++) {
+    IdStats &s = ids[(start + n) & (maxIds - 1)];
+    if (!s.used) {
+      s.used = true;
+      s.id = id;
+      s.count = 1;
+      s.last = now;
+      return;
+    }
+    if (s.id == id) {
+      uint32_t dt = now - s.last;
+      s.last = now;
+      s.count++;
+      if (s.interval == 0) {
+        s.interval = dt;
+      }
+      int32_t error = (int32_t)(dt - s.interval);
+      s.interval += error / 8;
+      s.jitter += ((error < 0 ? -error : error) - (int32_t)s.jitter) / 8;
+      return;
+    }
+  }
+
+  untrackedFrames++;
+}
+
+void BusStats::roll(uint32_t now) {
+  if (now - windowStart < windowMicros) {
+    return;
+  }
+
+  // a gap of several windows means nothing arrived in the last one.
+  // windows stay on a 1 s grid. restarting from now would let a window on
+  // a sparse bus run past 1 s while its count is still read as per second
+  uint32_t elapsed = now - windowStart;
+  bool quiet = elapsed >= 2 * windowMicros;
+  windowStart += elapsed - elapsed % windowMicros;
+
+  lastBits = quiet ? 0 : bits;
+  lastStuffBits = quiet ? 0 : stuffBits;
+  lastUntracked = quiet ? 0 : untrackedFrames;
+  bits = stuffBits = untrackedFrames = 0;
+
+  for (int i = 0; i < maxIds; i++) {
+    ids[i].rate = quiet ? 0 : ids[i].count;
+    ids[i].count = 0;
+  }
+}
+
+uint16_t BusStats::loadMin() const {
+  return lastBits * 1000 / bitRate; // fits, even a 1M bus is ~1.3M bits/s
+}
+
+uint16_t BusStats::loadMax() const {
+  return (lastBits + lastStuffBits) * 1000 / bitRate;
+}
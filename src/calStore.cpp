@@ -0,0 +1,59 @@
+/*
+   Calibration persistence
+ */
+
+#include "calStore.h"
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "crc16.h"
+#include "eepromLayout.h"
+
+static const uint16_t calVersion = 1; // bump if Calibration changes
+
+struct CalRecord {
+  uint16_t version;
+  Calibration cal;
+  uint16_t crc; // over version and cal
+};
+
+static_assert(sizeof(CalRecord) <= eepromCalSize, "calibration too big");
+
+static uint16_t recordCrc(const CalRecord &record) {
+  return crc16(&record, offsetof(CalRecord, crc));
+}
+
+bool loadCalibration(Calibration &cal) {
+  CalRecord record;
+  EEPROM.get(eepromCalStart, record);
+  if (record.version != calVersion || record.crc != recordCrc(record) ||
+      !calibrationValid(record.cal)) {
+    return false;
+  }
+  cal = record.cal;
+  return true;
+}
+
+bool saveCalibration(const Calibration &cal) {
+  CalRecord record;
+  memset(&record, 0, sizeof(record)); // keep the padding out of the crc
+  record.version = calVersion;
+  record.cal = cal;
+  record.crc = recordCrc(record);
+  EEPROM.put(eepromCalStart, record);
+
+  Calibration check;
+  return loadCalibration(check) && memcmp(&check, &cal, sizeof(cal)) == 0;
+}
+
+void printCalibration(const Calibration &cal) {
+  static const char *const names[NUM_CAL_PARAMS] = {
+      "wakeup", "shift rpm",   "redline",     "brightness", "battery empty",
+      "battery full", "battery low", "battery mid", "battery high"};
+  for (int i = 0; i < NUM_CAL_PARAMS; i++) {
+    Serial.print(names[i]);
+    Serial.print(' ');
+    Serial.println(calibrationGet(cal, i));
+  }
+}
@@ -0,0 +1,106 @@
+/*
+   Display calibration
+ */
+
+#include "calibration.h"
+
+bool calibrationValid(const Calibration &cal) {
+  return cal.wakeUp < cal.shiftRpm && cal.shiftRpm < cal.redline &&
+         cal.redline - cal.wakeUp >= numLeds && // at least 1 rpm per led
+         cal.batteryEmpty < cal.batteryFull &&
+         cal.batteryLow <= cal.batteryMid &&
+         cal.batteryMid <= cal.batteryHigh &&
+         cal.batteryFull <= DisplayTables::maxVolts;
+}
+
+uint16_t calibrationGet(const Calibration &cal, int param) {
+  switch (param) {
+  case CAL_WAKEUP:
+    return cal.wakeUp;
+  case CAL_SHIFT_RPM:
+    return cal.shiftRpm;
+  case CAL_REDLINE:
+    return cal.redline;
+  case CAL_BRIGHTNESS:
+    return cal.brightness;
+  case CAL_BATTERY_EMPTY:
+    return cal.batteryEmpty;
+  case CAL_BATTERY_FULL:
+    return cal.batteryFull;
+  case CAL_BATTERY_LOW:
+    return cal.batteryLow;
+  case CAL_BATTERY_MID:
+    return cal.batteryMid;
+  case CAL_BATTERY_HIGH:
+    return cal.batteryHigh;
+  }
+  return 0;
+}
+
+CalStatus calibrationSet(Calibration &cal, int param, uint16_t value) {
+  Calibration next = cal;
+  bool byteParam = param >= CAL_BRIGHTNESS;
+  if (byteParam && value > 255) {
+    return CAL_BAD_VALUE;
+  }
+
+  switch (param) {
+  case CAL_WAKEUP:
+    next.wakeUp = value;
+    break;
+  case CAL_SHIFT_RPM:
+    next.shiftRpm = value;
+    break;
+  case CAL_REDLINE:
+    next.redline = value;
+    break;
+  case CAL_BRIGHTNESS:
+    next.brightness = value;
+    break;
+  case CAL_BATTERY_EMPTY:
+    next.batteryEmpty = value;
+    break;
+  case CAL_BATTERY_FULL:
+    next.batteryFull = value;
+    break;
+  case CAL_BATTERY_LOW:
+    next.batteryLow = value;
+    break;
+  case CAL_BATTERY_MID:
+    next.batteryMid = value;
+    break;
+  case CAL_BATTERY_HIGH:
+    next.batteryHigh = value;
+    break;
+  default:
+    return CAL_BAD_PARAM;
+  }
+
+  if (!calibrationValid(next)) {
+    return CAL_BAD_VALUE;
+  }
+  cal = next;
+  return CAL_OK;
+}
+
+void buildTables(const Calibration &cal, DisplayTables &tables) {
+  tables.rpmPerLed = (cal.redline - cal.wakeUp) / numLeds;
+
+  for (int v = 0; v <= DisplayTables::maxVolts; v++) {
+    // same rounding as the map() it replaces, clamped to the strip
+    int leds = (v - cal.batteryEmpty) * numLeds /
+               (cal.batteryFull - cal.batteryEmpty);
+    tables.batteryLeds[v] = leds < 0 ? 0 : leds > numLeds ? numLeds : leds;
+
+    Rgb &c = tables.batteryColor[v];
+    if (v < cal.batteryLow) {
+      c = {255, 0, 0};
+    } else if (v < cal.batteryMid) {
+      c = {255, 255, 0};
+    } else if (v < cal.batteryHigh) {
+      c = {0, 255, 0};
+    } else {
+      c = {0, 0, 255};
+    }
+  }
+}
@@ -0,0 +1,126 @@
+/*
+   Event capture persistence and serial dump
+   EEPROM format: a header, then packed records of
+   int16 ms from trigger, uint32 id, uint8 len, 8 data bytes, 1 pad byte.
+ */
+
+#include "captureStore.h"
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "eepromLayout.h"
+
+static const uint32_t captureMagic = 0x43415031; // "CAP1"
+
+struct SavedHeader {
+  uint32_t magic;
+  uint8_t reason;
+  uint8_t count;
+  uint8_t triggerFrame;
+  uint8_t pad;
+  uint32_t triggerMicros;
+};
+
+struct SavedFrame {
+  int16_t ms; // relative to the trigger
+  uint32_t id;
+  uint8_t len;
+  uint8_t buf[8];
+  uint8_t pad;
+} __attribute__((packed));
+
+static const int maxSaved =
+    (eepromCaptureSize - sizeof(SavedHeader)) / sizeof(SavedFrame);
+static const int savedPost = maxSaved / 4; // most of the room goes before
+
+static void printLine(int32_t t, uint32_t id, uint8_t len,
+                      const uint8_t *buf) {
+  Serial.print(t);
+  Serial.print(" ID: ");
+  Serial.print(id, HEX);
+  Serial.print(" Data: ");
+  for (int c = 0; c < len; c++) {
+    Serial.print(buf[c], HEX);
+    Serial.write(' ');
+  }
+  Serial.write('\r');
+  Serial.write('\n');
+}
+
+void saveCapture(const EventCapture &capture) {
+  int trigger = capture.triggerFrame();
+  int last = trigger + savedPost;
+  if (last > capture.count()) {
+    last = capture.count();
+  }
+  int first = last - maxSaved;
+  if (first < 0) {
+    first = 0;
+  }
+
+  SavedHeader header = {captureMagic, capture.reason(),
+                        (uint8_t)(last - first), (uint8_t)(trigger - first),
+                        0, capture.triggerTime()};
+
+  // the old header stays valid while its records are overwritten, so clear
+  // its magic first. a save cut short by power loss then reads as empty
+  // rather than as old and new frames mixed
+  EEPROM.put(eepromCaptureStart, (uint32_t)0);
+
+  int addr = eepromCaptureStart + sizeof(SavedHeader);
+  for (int i = first; i < last; i++) {
+    const CapturedFrame &f = capture.frame(i);
+    SavedFrame saved;
+    saved.ms = (int32_t)(f.micros - capture.triggerTime()) / 1000;
+    saved.id = f.id;
+    saved.len = f.len;
+    memcpy(saved.buf, f.buf, 8);
+    saved.pad = 0;
+    EEPROM.put(addr, saved);
+    addr += sizeof(SavedFrame);
+  }
+
+  // header last, once every record it describes is written
+  EEPROM.put(eepromCaptureStart, header);
+}
+
+void dumpCapture(const EventCapture &capture) {
+  Serial.print("capture reason ");
+  Serial.print(capture.reason());
+  Serial.print(" frames ");
+  Serial.println(capture.count());
+
+  for (int i = 0; i < capture.count(); i++) {
+    const CapturedFrame &f = capture.frame(i);
+    if (i == capture.triggerFrame()) {
+      Serial.println("--- trigger ---");
+    }
+    printLine((int32_t)(f.micros - capture.triggerTime()), f.id, f.len, f.buf);
+  }
+}
+
+void dumpSavedCapture(void) {
+  SavedHeader header;
+  EEPROM.get(eepromCaptureStart, header);
+  if (header.magic != captureMagic) {
+    Serial.println("no saved capture");
+    return;
+  }
+
+  Serial.print("saved capture reason ");
+  Serial.print(header.reason);
+  Serial.print(" frames ");
+  Serial.println(header.count);
+
+  int addr = eepromCaptureStart + sizeof(SavedHeader);
+  for (int i = 0; i < header.count; i++) {
+    SavedFrame saved;
+    EEPROM.get(addr, saved);
+    addr += sizeof(SavedFrame);
+    if (i == header.triggerFrame) {
+      Serial.println("--- trigger ---");
+    }
+    printLine(saved.ms * 1000L, saved.id, saved.len, saved.buf);
+  }
+}
@@ -0,0 +1,55 @@
+/*
+   Layered display compositor
+   Blending is 8 bit fixed point, out = src * (a + 1) + dst * (255 - a) >> 8,
+   which passes src through untouched at a = 255.
+ */
+
+#include "compositor.h"
+
+#include <string.h>
+
+void Layer::clear() { memset(alpha, 0, sizeof(alpha)); }
+
+void Layer::set(int i, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+  if (i < 0 || i >= numLeds) {
+    return;
+  }
+  color[i].r = r;
+  color[i].g = g;
+  color[i].b = b;
+  alpha[i] = a;
+}
+
+void Layer::fill(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+  for (int i = 0; i < numLeds; i++) {
+    set(i, r, g, b, a);
+  }
+}
+
+Compositor::Compositor() {
+  for (int i = 0; i < NUM_LAYERS; i++) {
+    layers[i].clear();
+  }
+  memset(out, 0, sizeof(out));
+}
+
+static inline uint8_t blend(uint8_t src, uint8_t dst, uint8_t a) {
+  return (uint8_t)((src * (a + 1) + dst * (255 - a)) >> 8);
+}
+
+void Compositor::compose() {
+  memset(out, 0, sizeof(out));
+
+  for (int l = 0; l < NUM_LAYERS; l++) {
+    const Layer &layer = layers[l];
+    for (int i = 0; i < numLeds; i++) {
+      uint8_t a = layer.alpha[i];
+      if (a == 0) {
+        continue;
+      }
+      out[i].r = blend(layer.color[i].r, out[i].r, a);
+      out[i].g = blend(layer.color[i].g, out[i].g, a);
+      out[i].b = blend(layer.color[i].b, out[i].b, a);
+    }
+  }
+}
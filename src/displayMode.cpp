@@ -0,0 +1,95 @@
+/*
+   Display mode state machine
+   Leaving the engine running modes, leaving the redline and moving between
+   battery and tps are the transitions that flapped, so they carry the
+   dwell. Starting the engine, the ECU going away and going over the
+   redline act at once, so the strobe starts on the first frame over it and
+   holds through a limiter bouncing off it.
+ */
+
+#include "displayMode.h"
+
+#include <string.h>
+
+const char *const modeNames[NUM_MODES] = {"wakeup", "heartbeat", "battery",
+                                          "tps",    "tach",      "redline"};
+
+static const uint16_t modeDwellMs = 250;
+
+static bool offline(const ModeInputs &in) {
+  return in.wakeupComplete && !in.ecuOnline;
+}
+static bool online(const ModeInputs &in) {
+  return in.wakeupComplete && in.ecuOnline;
+}
+static bool running(const ModeInputs &in) { return in.rpm > modeRunningRpm; }
+static bool stopped(const ModeInputs &in) { return in.rpm < modeStoppedRpm; }
+static bool overRedline(const ModeInputs &in) { return in.rpm > in.redline; }
+static bool belowRedline(const ModeInputs &in) {
+  return in.rpm < in.redline - modeRedlineDrop;
+}
+static bool throttleOpen(const ModeInputs &in) {
+  return in.tps > modeTpsShow;
+}
+static bool throttleClosed(const ModeInputs &in) {
+  return in.tps < modeTpsHide;
+}
+static bool stoppedThrottleOpen(const ModeInputs &in) {
+  return stopped(in) && throttleOpen(in);
+}
+
+static const ModeTransition modeTable[] = {
+    {MODE_ANY, MODE_HEARTBEAT, offline, 0},
+    {MODE_WAKEUP, MODE_BATTERY, online, 0},
+    {MODE_HEARTBEAT, MODE_BATTERY, online, 0},
+    {MODE_BATTERY, MODE_TACH, running, 0},
+    {MODE_TPS, MODE_TACH, running, 0},
+    {MODE_TACH, MODE_REDLINE, overRedline, 0},
+    {MODE_REDLINE, MODE_TACH, belowRedline, modeDwellMs},
+    {MODE_TACH, MODE_TPS, stoppedThrottleOpen, modeDwellMs},
+    {MODE_TACH, MODE_BATTERY, stopped, modeDwellMs},
+    {MODE_BATTERY, MODE_TPS, throttleOpen, modeDwellMs},
+    {MODE_TPS, MODE_BATTERY, throttleClosed, modeDwellMs},
+};
+
+static const int numTransitions = sizeof(modeTable) / sizeof(modeTable[0]);
+
+ModeMachine::ModeMachine() : current(MODE_WAKEUP), since(0), heldBack(0) {
+  memset(enter, 0, sizeof(enter));
+  memset(exit, 0, sizeof(exit));
+  memset(fired, 0, sizeof(fired));
+}
+
+void ModeMachine::update(const ModeInputs &in, uint32_t now) {
+  for (int i = 0; i < numTransitions; i++) {
+    const ModeTransition &t = modeTable[i];
+    if (t.to == current || (t.from != MODE_ANY && t.from != current)) {
+      continue;
+    }
+    if (!t.guard(in)) {
+      continue;
+    }
+    if (now - since < t.dwellMs) {
+      heldBack++;
+      return;
+    }
+
+    DisplayMode from = current;
+    DisplayMode to = (DisplayMode)t.to;
+    if (exit[from]) {
+      exit[from](from, to, now);
+    }
+    current = to;
+    since = now;
+    fired[from][to]++;
+    if (enter[to]) {
+      enter[to](from, to, now);
+    }
+    return;
+  }
+}
+
+void ModeMachine::resetCounters() {
+  memset(fired, 0, sizeof(fired));
+  heldBack = 0;
+}
@@ -0,0 +1,64 @@
+/*
+   Pre-trigger event capture
+   The ring index is a free running counter masked by size - 1, so recording
+   never branches on wrap.
+ */
+
+#include "eventCapture.h"
+
+#include <string.h>
+
+EventCapture::EventCapture()
+    : head(0), status(CAPTURE_ARMED), triggerReason(0), triggerHead(0),
+      triggerMicros(0) {}
+
+void EventCapture::record(uint32_t micros, uint32_t id, uint8_t len,
+                          const uint8_t *buf) {
+  if (status == CAPTURE_FROZEN) {
+    return;
+  }
+
+  CapturedFrame &f = ring[head & (size - 1)];
+  f.micros = micros;
+  f.id = id;
+  f.len = len;
+  memcpy(f.buf, buf, 8);
+  head = head + 1;
+
+  if (status == CAPTURE_TRIGGERED && head - triggerHead >= (uint32_t)postFrames) {
+    status = CAPTURE_FROZEN;
+  }
+}
+
+bool EventCapture::trigger(uint8_t reason, uint32_t micros) {
+  if (status != CAPTURE_ARMED) {
+    return false;
+  }
+  triggerReason = reason;
+  triggerHead = head;
+  triggerMicros = micros;
+  status = CAPTURE_TRIGGERED;
+  return true;
+}
+
+void EventCapture::poll(uint32_t micros) {
+  // record() freezes on a full window, this covers the bus going quiet
+  if (status == CAPTURE_TRIGGERED && micros - triggerMicros >= postMicros) {
+    status = CAPTURE_FROZEN;
+  }
+}
+
+void EventCapture::rearm() {
+  head = 0;
+  status = CAPTURE_ARMED;
+}
+
+int EventCapture::count() const { return head < (uint32_t)size ? head : size; }
+
+const CapturedFrame &EventCapture::frame(int i) const {
+  return ring[(head - count() + i) & (size - 1)];
+}
+
+int EventCapture::triggerFrame() const {
+  return count() - (int)(head - triggerHead);
+}
@@ -0,0 +1,79 @@
+/*
+   Signal conditioning
+   The IIR keeps 8 fraction bits so small alphas still move on slow
+   channels, and its multiply is done in 64 bits since a 16 bit channel
+   shifted up 8 leaves too little room for an 8 bit weight.
+ */
+
+#include "filters.h"
+
+static int32_t median(const FilterConfig &config, FilterState &state,
+                      int32_t x) {
+  int n = config.median;
+  if (n <= 1) {
+    return x;
+  }
+  if (n > FilterState::maxMedian) {
+    n = FilterState::maxMedian;
+  }
+
+  state.window[state.next] = x;
+  state.next = (state.next + 1) % n;
+  if (state.filled < n) {
+    state.filled++;
+  }
+
+  // insertion sort of at most five
+  int32_t sorted[FilterState::maxMedian];
+  int count = state.filled;
+  for (int i = 0; i < count; i++) {
+    int32_t v = state.window[i];
+    int j = i;
+    while (j > 0 && sorted[j - 1] > v) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+  return sorted[(count - 1) / 2];
+}
+
+int32_t filterSample(const FilterConfig &config, FilterState &state,
+                     int32_t x, uint32_t now) {
+  int32_t m = median(config, state, x);
+
+  if (!state.primed) {
+    state.primed = true;
+    state.iir = m * 256;
+    state.out = m;
+    state.lastMs = now;
+    return m;
+  }
+
+  int32_t y = m;
+  if (config.iirAlpha < 256) {
+    int64_t error = (int64_t)m * 256 - state.iir;
+    state.iir += (int32_t)((error * config.iirAlpha) / 256);
+    y = (state.iir + 128) >> 8;
+  }
+
+  uint32_t dt = now - state.lastMs;
+  state.lastMs = now;
+  if (config.maxRate > 0) {
+    if (dt > 1000) {
+      dt = 1000; // a long gap just allows a second's worth
+    }
+    int32_t step = (int32_t)((int64_t)config.maxRate * dt / 1000);
+    if (step < 1) {
+      step = 1;
+    }
+    if (y > state.out + step) {
+      y = state.out + step;
+    } else if (y < state.out - step) {
+      y = state.out - step;
+    }
+  }
+
+  state.out = y;
+  return y;
+}
@@ -0,0 +1,101 @@
+/*
+   LED strip drivers
+   Only the one named by LED_DRIVER is called, the linker drops the other.
+   Both keep their state in fixed statics and any frame buffer belongs to
+   the strip, sized from its length, so nothing is allocated.
+ */
+
+#include "ledStrip.h"
+
+#include <Arduino.h>
+#include <SPI.h>
+
+// -------------------------------------------------------------
+// WS2812, 1.25 us per bit: high for 0.25 us for a 0 or 0.8 us for a 1. the
+// strip latches once the line has been low for a while, 300 us covers the
+// newer parts
+static const uint32_t ws2812Bit = F_CPU / 800000;
+static const uint32_t ws2812High0 = F_CPU / 4000000;
+static const uint32_t ws2812High1 = F_CPU / 1250000;
+static const uint32_t ws2812LatchMicros = 300;
+
+// with several strips only the one just sent can still be latching
+static uint8_t ws2812LastPin = 0xFF;
+static uint32_t ws2812Done; // micros() at the end of the last frame
+
+void Ws2812Driver::begin(uint8_t pin) {
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+
+void Ws2812Driver::write(uint8_t pin, const uint8_t *bytes, int leds,
+                         uint8_t, uint8_t *) {
+  if (pin == ws2812LastPin) {
+    while (micros() - ws2812Done < ws2812LatchMicros) {
+    }
+  }
+
+  volatile uint8_t *ws2812Set = portSetRegister(pin);
+  volatile uint8_t *ws2812Clear = portClearRegister(pin);
+
+  const uint8_t *p = bytes;
+  const uint8_t *end = bytes + leds * 3;
+
+  noInterrupts();
+  uint32_t cyc = ARM_DWT_CYCCNT + ws2812Bit;
+  while (p < end) {
+    uint8_t pix = *p++;
+    for (uint8_t mask = 0x80; mask; mask >>= 1) {
+      while (ARM_DWT_CYCCNT - cyc < ws2812Bit) {
+      }
+      cyc = ARM_DWT_CYCCNT;
+      *ws2812Set = 1;
+      uint32_t high = (pix & mask) ? ws2812High1 : ws2812High0;
+      while (ARM_DWT_CYCCNT - cyc < high) {
+      }
+      *ws2812Clear = 1;
+    }
+  }
+  while (ARM_DWT_CYCCNT - cyc < ws2812Bit) {
+  }
+  interrupts();
+
+  ws2812LastPin = pin;
+  ws2812Done = micros();
+}
+
+// -------------------------------------------------------------
+// start frame of 32 zero bits, then per led 111 + 5 bit current, b, g, r.
+// the end frame is zeros: SK9822 wants 32 bits of them to latch and both
+// need half a clock per led to push the data through the chain. frame
+// holds frameBytes(leds), so a strip of any length goes out whole
+
+void Apa102Driver::begin(uint8_t pin) {
+  SPI.setSCK(pin); // pin 13 is the CAN activity led, so usually 14
+  SPI.begin();
+}
+
+void Apa102Driver::write(uint8_t, const uint8_t *bytes, int leds,
+                         uint8_t brightness, uint8_t *frame) {
+  uint8_t global = brightness >> 3;
+  if (brightness && !global) {
+    global = 1;
+  }
+
+  memset(frame, 0, 4);
+  uint8_t *p = frame + 4;
+  for (int i = 0; i < leds; i++) {
+    *p++ = 0xE0 | global;
+    *p++ = bytes[i * 3];
+    *p++ = bytes[i * 3 + 1];
+    *p++ = bytes[i * 3 + 2];
+  }
+  memset(p, 0, endBytes(leds));
+
+  SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE0));
+  SPI.transfer(frame, 0, frameBytes(leds));
+  SPI.endTransaction();
+}
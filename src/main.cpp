@@ -6,83 +6,264 @@
    PE3 CAN Protocol: http://pe-ltd.com/assets/AN400_CAN_Protocol_C.pdf
  */
 
-#include <Adafruit_NeoPixel.h>
 #include <FlexCAN.h>
 
-int wakeUp = 1500;
-int shiftRpm = 9000;
-int redline = 11250;
-int brightness = 255; // 0 to 255
+#include "baudDetect.h"
+#include "busStats.h"
+#include "calStore.h"
+#include "calibration.h"
+#include "canDispatch.h"
+#include "captureStore.h"
+#include "compositor.h"
+#include "displayMode.h"
+#include "ecuProfiles.h"
+#include "eventCapture.h"
+#include "layout.h"
+#include "ledStrip.h"
+#include "log.h"
+#include "scheduler.h"
+#include "seqlock.h"
+#include "sessionStats.h"
+#include "signals.h"
+#include "statsStore.h"
+#include "streamWriter.h"
+#include "tachBar.h"
+#include "warnings.h"
+
+// defaults, changeable over CAN and kept in EEPROM, see calibration.h
+const Calibration defaultCal = {
+    1500,       // wakeUp
+    9000,       // shiftRpm
+    11250,      // redline
+    255,        // brightness, 0 to 255
+    6, 15,      // battery volts for no leds and for all of them
+    10, 12, 13, // battery red below, yellow below, green below, else blue
+};
+uint32_t calId = 0x1FFFFA00; // extended, replies go out on calId + 1
+
 int delayVal = 35;    // set wakeup sequence speed
+bool smoothTach = true; // fade the leading led in between whole steps
+
+int Pe3Profile::oilPressureInput = 0;
+
+// what freezes the event capture, see eventCapture.h
+uint8_t captureTriggers = TRIGGER_OVERREV | TRIGGER_ECU_LOST;
+
+int idleAfter = 10000; // ms of heartbeat before going dark and sleeping
+
+uint32_t canBaud = EcuProfile::defaultBaud; // used if detection can't lock
+bool autoBaud = true;      // listen for the bus rate before joining it
+bool canListening = false; // detection didn't lock, baudTask keeps trying
+volatile uint16_t listenFrames = 0; // decoded while listening, for baudTask
 
-// control flags
-bool EngRunning = false;
-bool showingTPS = false;
-bool ecuOn = false;
-bool wakeupComplete = false;
+// when the ECU was last heard from, owned by the CAN callback. what that
+// means for the display is decided in loop(), see displayMode.h
+struct EcuState {
+  bool ecuOn;
+  uint32_t lastEcuMillis;
+  uint32_t lastEcuMicros; // for timing how quickly we wake up
+};
+
+EcuState ecu = {false, 0, 0};
+Seqlock<EcuState> ecuState; // published copy of ecu for loop()
+
+// written by setup(), read by the CAN callback. a single byte store can't
+// tear, and a seqlock can't be used in this direction since the callback
+// would spin on a writer it interrupted
+volatile bool wakeupComplete = false;
 
+// WS2812 data, or APA102 clock with data on 11. driver set in ledStrip.h
 int pixelPin = 14;
 
-long lastEcuMillis = 0;
+// the settings in use and what's derived from them. both are only written
+// by loop(), with the CAN callback held off for cal since it reads it too
+Calibration cal = defaultCal;
+DisplayTables tables;
 
-Adafruit_NeoPixel strip = Adafruit_NeoPixel(16, pixelPin, NEO_GRB + NEO_KHZ800);
+// display layout, see layout.h. the tach zone shows the compositor's frame,
+// the others are extra leds for when they're fitted, for example
+//   LedStrip<Ws2812Driver, 6> sideStrip; // begin() it on its own pin
+//   typedef Zone<LedStrip<Ws2812Driver, 6>, sideStrip, 0, 4> WarningZone;
+//   typedef Zone<LedStrip<Ws2812Driver, 6>, sideStrip, 4, 2, true> StatusZone;
+typedef LedStrip<LED_DRIVER, numLeds> MainStrip;
+MainStrip strip;
 
-void displayTPS(
-    double tp) { // display throttle position if engine is not running
-  strip.clear();
-  int ledsToLight = ceil(map(tp, 0, 100, 0, 16));
+typedef Zone<MainStrip, strip, 0, numLeds> TachZone;
+typedef NoZone WarningZone; // the top warning, solid
+typedef NoZone StatusZone;  // ECU and engine state
+
+static_assert(TachZone::length == numLeds, "tach zone must fit the frame");
+
+// every strip in the layout
+void showStrips(void) { strip.show(); }
+
+Compositor compositor;
+
+// views draw into a layer, the compositor owns the tach zone
+
+// display throttle position if engine is not running, tps in 0.1 %
+void displayTPS(Layer &layer, int tps) {
+  int ledsToLight = tpsBarLeds(tps, numLeds);
 
   for (int i = 0; i < ledsToLight; i++) {
-    strip.setPixelColor(i, 0, 255, 255);
+    layer.set(i, 0, 255, 255);
   }
-  strip.show();
 }
 
-void setLights(int rpm) {
+// bands and led count come from the calibration tables
+void displayBattery(Layer &layer, int voltage) {
+  if (voltage > DisplayTables::maxVolts) {
+    voltage = DisplayTables::maxVolts;
+  }
+  int ledsToLight = tables.batteryLeds[voltage];
+  Rgb batColor = tables.batteryColor[voltage];
 
-  if (rpm < shiftRpm) { // ----- NORMAL REVS -----
+  for (int i = 0; i < ledsToLight; i++) {
+    layer.set(i, batColor.r, batColor.g, batColor.b);
+  }
+}
 
-    strip.clear();
+// lights the bar up to the current rpm, fading the leading led
+void drawBar(Layer &layer, int rpm, uint8_t r, uint8_t g, uint8_t b) {
+  TachBar bar = tachBarPosition(rpm, tables.rpmPerLed, numLeds, smoothTach);
+
+  for (int i = 0; i < bar.fullLeds; i++) {
+    layer.set(i, r, g, b);
+  }
+  if (bar.leadLevel) {
+    layer.set(bar.fullLeds, scaleChannel(r, bar.leadLevel),
+              scaleChannel(g, bar.leadLevel), scaleChannel(b, bar.leadLevel));
+  }
+}
 
-    int numLEDs = strip.numPixels();
-    float rpmPerLED =
-        ((redline - wakeUp) / numLEDs); // calculates how many rpm per led
-    int ledsToLight = ceil(rpm / rpmPerLED);
+// base bar is always green, the shift layer covers it from the shift point.
+// the strobe follows MODE_REDLINE, so it keeps the mode's hysteresis
+void setLights(Layer &base, Layer &shift, int rpm, bool redline,
+               uint32_t now) {
+  drawBar(base, rpm, 0, 255, 0);
 
-    for (int i = 0; i <= ledsToLight; i++) {
+  if ((rpm > cal.shiftRpm) && (rpm < cal.redline)) { // ----- SHIFT POINT-----
+    drawBar(shift, rpm, 255, 255, 0);        // yellow
+  }
 
-      strip.setPixelColor(i, 0, 255, 0);
+  if (redline) { //----- REDLINE -----
+    if ((now / 20) % 2 == 0) {
+      shift.fill(255, 0, 0);
+    } else {
+      shift.fill(0, 0, 0);
     }
+  }
+}
 
-    strip.show();
+// warnings flash at half strength so the bar still shows through
+void drawWarnings(Layer &layer, bool engRunning, uint32_t now) {
+  evaluateWarnings(engRunning, now);
+
+  int top = topWarning();
+  if (top < 0 || (now / 125) % 2) {
+    return;
   }
 
-  if ((rpm > shiftRpm) && (rpm < redline)) { // ----- SHIFT POINT-----
-    strip.clear();
+  const WarningRule &rule = warningRules[top];
+  layer.fill(rule.r, rule.g, rule.b, 128);
+}
 
-    int numLEDs = strip.numPixels();
-    float rpmPerLED =
-        ((redline - wakeUp) / numLEDs); // calculates how many rpm per led
-    int ledsToLight = ceil(rpm / rpmPerLED);
+// the warning cluster, for when the warning shouldn't cover the tach
+void drawWarningZone(void) {
+  int top = topWarning();
+  if (top < 0) {
+    WarningZone::fill(0, 0, 0);
+  } else {
+    const WarningRule &rule = warningRules[top];
+    WarningZone::fill(rule.r, rule.g, rule.b);
+  }
+}
 
-    for (int i = 0; i <= ledsToLight; i++) {
+bool engineRunning(DisplayMode mode) {
+  return mode == MODE_TACH || mode == MODE_REDLINE;
+}
 
-      strip.setPixelColor(i, 255, 255, 0); // yellow
-    }
+// red with no ECU, blue with the ECU up and the engine off, green running
+void drawStatusZone(DisplayMode mode) {
+  if (mode == MODE_HEARTBEAT || mode == MODE_WAKEUP) {
+    StatusZone::fill(255, 0, 0);
+  } else if (engineRunning(mode)) {
+    StatusZone::fill(0, 255, 0);
+  } else {
+    StatusZone::fill(0, 0, 255);
+  }
+}
 
-    strip.show();
+// red double pulse while there's no ECU. same timing as the old delay()
+// based heartbeat, but drawn from the clock so nothing has to block
+void drawHeartbeat(Layer &layer, uint32_t now) {
+  uint32_t phase = now % 1820;
+  if (phase < 70 || (phase >= 150 && phase < 220)) {
+    layer.fill(255, 0, 0);
+  } else {
+    layer.fill(40, 0, 0);
   }
+}
 
-  if (rpm > redline) { //----- REDLINE -----
-    for (unsigned int i = 0; i < strip.numPixels(); i++) {
-      strip.setPixelColor(i, 255, 0, 0);
+uint32_t composeCycles = 0;
+uint32_t maxComposeCycles = 0;
+uint32_t showCycles = 0; // what the led driver costs per frame
+uint32_t maxShowCycles = 0;
+
+void render(DisplayMode mode, uint32_t now) {
+  Layer &base = compositor.layer(LAYER_BASE);
+  Layer &shift = compositor.layer(LAYER_SHIFT);
+  Layer &warning = compositor.layer(LAYER_WARNING);
+  base.clear();
+  shift.clear();
+  warning.clear();
+
+  // stale channels draw nothing rather than a frozen bar
+  switch (mode) {
+  case MODE_WAKEUP: // the light show owns the strip
+    break;
+  case MODE_HEARTBEAT:
+    drawHeartbeat(base, now);
+    break;
+  case MODE_BATTERY:
+    if (signalFresh(SIG_VOLTS)) {
+      displayBattery(base, signals[SIG_VOLTS].value / 100);
     }
+    break;
+  case MODE_TPS:
+    if (signalFresh(SIG_TPS)) {
+      displayTPS(base, signals[SIG_TPS].value);
+    }
+    break;
+  case MODE_TACH:
+  case MODE_REDLINE:
+    if (signalFresh(SIG_RPM)) {
+      setLights(base, shift, signals[SIG_RPM].value, mode == MODE_REDLINE,
+                now);
+    }
+    break;
+  default:
+    break;
+  }
 
-    strip.show();
-    delay(20);
-    strip.clear();
-    strip.show();
-    delay(20);
+  drawWarnings(warning, engineRunning(mode), now);
+
+  uint32_t start = ARM_DWT_CYCCNT;
+  compositor.compose();
+  composeCycles = ARM_DWT_CYCCNT - start;
+  if (composeCycles > maxComposeCycles) {
+    maxComposeCycles = composeCycles;
+  }
+
+  TachZone::copy(compositor.frame());
+  drawWarningZone();
+  drawStatusZone(mode);
+
+  start = ARM_DWT_CYCCNT;
+  showStrips();
+  showCycles = ARM_DWT_CYCCNT - start;
+  if (showCycles > maxShowCycles) {
+    maxShowCycles = showCycles;
   }
 }
 
@@ -104,73 +285,98 @@ void canClass::printFrame(CAN_message_t &frame, int mailbox) {
   Serial.write('\n');
 }
 
-void canClass::gotFrame(CAN_message_t &frame,
-                        int mailbox) // runs every time a frame is recieved
-{
+EventCapture capture; // last few seconds of frames, frozen on a trigger
+SessionStats stats;   // kept across power cycles in EEPROM
+BusStats busStats(canBaud);
 
-  printFrame(frame, mailbox);
-  digitalWrite(13, !digitalRead(13));
+// collects what the profile decoded out of one frame
+struct SignalSink {
+  uint32_t now;
+  uint32_t updated; // bit per SignalId
 
-  if (frame.id == 218099784) { // frame has rpm and tps percentage
+  void set(SignalId id, int32_t value) {
+    updateSignal(id, value, now);
+    updated |= 1UL << id;
+  }
+};
 
-    ecuOn = true;             // this frame can only come from the ECU
-    lastEcuMillis = millis(); // start a timer for the next frame
+// the rpm only ever comes from the ECU, so it marks the ECU as alive
+void markEcuAlive(uint32_t now) {
+  ecu.ecuOn = true;
+  ecu.lastEcuMillis = now; // start a timer for the next frame
+  ecu.lastEcuMicros = micros();
+  ecuState.write(ecu);
+}
 
-    int lowByte = frame.buf[0];
-    int highByte = frame.buf[1];
-    int newRPM = ((highByte * 256) + lowByte);
+void onEcuFrame(const CAN_message_t &frame) {
+  SignalSink out = {millis(), 0};
+  EcuProfile::decode(frame.id, frame.buf, out);
 
-    if (newRPM > 500) {
-      EngRunning = true;
-      showingTPS = false;
-      setLights(newRPM);
-    } else {
-      EngRunning = false;
-      double lowByte = frame.buf[2];
-      double highByte = frame.buf[3];
-      double tps = ((highByte * 256) + lowByte) / 10;
-      if (tps > 20) {
-        showingTPS = true;
-        displayTPS(tps);
-      } else {
-        showingTPS = false;
-      }
+  if (out.updated & (1UL << SIG_RPM)) {
+    markEcuAlive(out.now);
+    stats.onRpm(signals[SIG_RPM].value, out.now, cal.shiftRpm, cal.redline);
+
+    if ((captureTriggers & TRIGGER_OVERREV) &&
+        signals[SIG_RPM].value > cal.redline) {
+      capture.trigger(TRIGGER_OVERREV, micros());
     }
   }
 
-  // this frame carries voltage, air temp, and coolant temp
-  if (frame.id == 218101064 && EngRunning == false && ecuOn == true &&
-      showingTPS == false && wakeupComplete == true) {
-    strip.clear();
+  if (out.updated & (1UL << SIG_VOLTS)) {
+    stats.onVolts(signals[SIG_VOLTS].value);
+  }
 
-    int lowByte = frame.buf[0];
-    int highByte = frame.buf[1];
-    int voltage = ((highByte * 256) + lowByte);
-    voltage /= 100;
-    Serial.println(voltage);
-
-    int ledsToLight =
-        ceil(map(voltage, 6, 15, 0, strip.numPixels())); // turn on some leds
-
-    uint32_t batColor; // color of strip to show battery status
-    if (voltage < 10) {
-      batColor = strip.Color(255, 0, 0);
-    } else if (voltage >= 10 && voltage < 12) {
-      batColor = strip.Color(255, 255, 0);
-    } else if (voltage >= 12 && voltage < 13) {
-      batColor = strip.Color(0, 255, 0);
-    } else if (voltage >= 13) {
-      batColor = strip.Color(0, 0, 255);
-    }
+  if ((out.updated & (1UL << SIG_VOLTS)) && wakeupComplete) {
+    LOG_DEBUG(LOG_ECU, "battery %d V", (int)(signals[SIG_VOLTS].value / 100));
+  }
+}
 
-    for (int i = 0; i < ledsToLight; i++) {
-      strip.setPixelColor(i, batColor);
-    }
+// calibration requests are answered from loop(), since saving to EEPROM is
+// far too slow for the callback. one request at a time, the tool waits for
+// each reply
+volatile bool calPending = false;
+CAN_message_t calRequest;
+uint32_t calDropped = 0; // arrived before the last one was answered
+uint32_t calMalformed = 0; // not 8 bytes, so not a request
+
+void onCalFrame(const CAN_message_t &frame) {
+  // bytes past len are left over from the last frame, don't read them as a
+  // value
+  if (frame.len != 8) {
+    calMalformed++;
+    return;
+  }
+  if (calPending) {
+    calDropped++;
+    return;
+  }
+  calRequest = frame;
+  calPending = true;
+}
 
-    strip.show();
+CanDispatch<CAN_message_t> canDispatch;
+
+void canClass::gotFrame(CAN_message_t &frame,
+                        int mailbox) // runs every time a frame is recieved
+{
+
+  if (LOG_ENABLED(LOG_LEVEL_TRACE, LOG_CAN)) {
+    printFrame(frame, mailbox);
+  }
+  digitalWrite(13, !digitalRead(13));
+
+  if (canListening) {
+    listenFrames++;
   }
+
+  uint32_t now = micros();
+  capture.record(now, frame.id, frame.len, frame.buf);
+  busStats.update(frame.id, frame.ext, frame.len, now);
+  canDispatch.dispatch(frame);
 }
 
+canClass canListener; // must outlive setup(), FlexCAN keeps a pointer to it
+
 // -------------------------------------------------------------
 
 void lightShow(void) {
@@ -252,71 +458,440 @@ void lightShow(void) {
   wakeupComplete = true;
 }
 
-void setup(void) {
-  Serial.println("online");
+// the host replay provides its own, which moves its clock on to the next tick
+#ifndef WAIT_FOR_INTERRUPT
+#define WAIT_FOR_INTERRUPT() __asm__ __volatile__("wfi")
+#endif
 
-  canClass canClass;
+// sleeps with the strip dark until the ECU comes back. the CAN message
+// interrupt stays enabled and the rx FIFO keeps running while the core is
+// halted, so the frame that wakes us is decoded and drawn as normal
+void idleUntilEcu(void) {
+  strip.clear();
+  WarningZone::fill(0, 0, 0);
+  StatusZone::fill(0, 0, 0);
+  showStrips();
+  LOG_INFO(LOG_SYS, "Idle");
+
+  uint32_t sleepStart = millis();
+  uint32_t published = ecuState.writes();
+
+  // calibration requests and serial commands are served by their tasks,
+  // so they wake us as well as the ECU does
+  while (ecuState.writes() == published && !calPending &&
+         !Serial.available()) {
+    WAIT_FOR_INTERRUPT(); // systick wakes us every ms to recheck
+  }
 
-  Can0.begin(250000); // PE3 ECU SPEED
+  if (ecuState.writes() == published) {
+    LOG_INFO(LOG_SYS, "Woke after %lu ms for a request",
+             (unsigned long)(millis() - sleepStart));
+    return;
+  }
 
-  // Allow Extended CAN id's through
-  CAN_filter_t allPassFilter;
-  allPassFilter.ext = 1;
-  for (uint8_t filterNum = 1; filterNum < 16;
-       filterNum++) { // original filternum was 8
-    Can0.setFilter(allPassFilter, filterNum);
+  uint32_t latency = micros() - ecuState.read().lastEcuMicros;
+
+  LOG_INFO(LOG_SYS, "Woke after %lu ms, frame to loop %lu us",
+           (unsigned long)(millis() - sleepStart), (unsigned long)latency);
+}
+
+// -------------------------------------------------------------
+// loop() just runs whichever of these is due
+
+Scheduler scheduler(micros);
+
+EcuState state; // loop's copy of the ECU state, refreshed every ms
+bool ecuOnline = false;
+ModeMachine displayMode;
+
+// entry and exit actions, registered in setup()
+void ecuLost(DisplayMode from, DisplayMode, uint32_t) {
+  if (from == MODE_WAKEUP) {
+    return; // never had it
   }
+  LOG_WARN(LOG_ECU, "ECU Offline");
 
-  pinMode(13, OUTPUT);
-  digitalWrite(13, HIGH);
-  Can0.attachObj(&canClass);
-  canClass.attachGeneralHandler();
+  if (captureTriggers & TRIGGER_ECU_LOST) {
+    noInterrupts(); // the CAN callback also triggers and records
+    capture.trigger(TRIGGER_ECU_LOST, micros());
+    interrupts();
+  }
+}
 
-  strip.begin();
-  strip.setBrightness(brightness);
-  strip.show();
+void ecuFound(DisplayMode, DisplayMode, uint32_t) {
+  LOG_INFO(LOG_ECU, "ECU Online");
+}
 
-  lightShow();
+void checkTask(uint32_t) {
+  state = ecuState.read();
+  uint32_t now = millis();
+  checkStale(now);
+
+  // the callback can land between reading the state and millis()
+  ecuOnline = state.ecuOn && (int32_t)(now - state.lastEcuMillis) <= 2000;
+
+  ModeInputs in = {wakeupComplete, ecuOnline, signals[SIG_RPM].value,
+                   signals[SIG_TPS].value, cal.redline};
+  displayMode.update(in, now);
 }
 
-// -------------------------------------------------------------
-void loop(void) {
+// keeps sweeping the bus rates while detection hasn't locked, and joins
+// the bus once one scores clean
+void baudTask(uint32_t) {
+  if (!canListening) {
+    return;
+  }
+  noInterrupts();
+  uint16_t frames = listenFrames;
+  listenFrames = 0;
+  interrupts();
+
+  uint32_t baud;
+  if (!retryBaud(frames, millis(), baud)) {
+    return;
+  }
+  joinBus();
+  canListening = false;
+  canBaud = baud;
+  busStats.setBaud(canBaud);
+  LOG_INFO(LOG_CAN, "CAN locked at %lu, leaving listen only",
+           (unsigned long)canBaud);
+}
+
+void renderTask(uint32_t) { render(displayMode.mode(), millis()); }
 
-  if ((millis() - lastEcuMillis) > 2000) {
-    ecuOn = false;
-    EngRunning = false;
-    Serial.println("ECU Offline");
+void idleTask(uint32_t) {
+  uint32_t now = millis();
+  if (displayMode.mode() == MODE_HEARTBEAT &&
+      displayMode.timeInMode(now) > (uint32_t)idleAfter) {
+    idleUntilEcu();
+    displayMode.restartDwell(millis()); // a fresh idleAfter, noise or not
+    scheduler.resync(); // don't count the sleep as missed periods
   }
+}
 
-  delay(100);
-  if (EngRunning == false && showingTPS == false &&
-      ecuOn == false) { // heartbeat
-    for (int i = 0; i <= strip.numPixels(); i++) {
-      strip.setPixelColor(i, 255, 0, 0);
-      strip.show();
+void printModes(void) {
+  Serial.printf("mode %s for %lu ms, held back %lu\r\n",
+                modeNames[displayMode.mode()],
+                (unsigned long)displayMode.timeInMode(millis()),
+                (unsigned long)displayMode.held());
+  Serial.println("from,to,count");
+  for (int from = 0; from < NUM_MODES; from++) {
+    for (int to = 0; to < NUM_MODES; to++) {
+      if (displayMode.transitions(from, to)) {
+        Serial.printf("%s,%s,%lu\r\n", modeNames[from], modeNames[to],
+                      (unsigned long)displayMode.transitions(from, to));
+      }
     }
+  }
+}
 
-    delay(70);
+void captureTask(uint32_t now) {
+  static bool saved = false;
 
-    for (int i = 0; i < strip.numPixels(); i++) {
-      strip.setPixelColor(i, 40, 0, 0);
-      strip.show();
-    }
+  capture.poll(now);
+  if (capture.state() != CAPTURE_FROZEN) {
+    saved = false;
+  } else if (!saved) {
+    saveCapture(capture);
+    saved = true;
+    LOG_INFO(LOG_CAPTURE, "capture saved");
+  }
+}
+
+// the CAN callback updates stats, take a copy with it held off
+SessionStats statsSnapshot(void) {
+  noInterrupts();
+  SessionStats copy = stats;
+  interrupts();
+  return copy;
+}
 
-    delay(80);
+// puts new settings in place and rebuilds everything derived from them
+void applyCalibration(const Calibration &next) {
+  noInterrupts(); // the CAN callback compares against the rpm limits
+  cal = next;
+  interrupts();
+  buildTables(cal, tables);
+  strip.setBrightness(cal.brightness);
+}
 
-    for (int i = 0; i < strip.numPixels(); i++) {
-      strip.setPixelColor(i, 255, 0, 0);
-      strip.show();
+void calTask(uint32_t) {
+  if (!calPending) {
+    return;
+  }
+  noInterrupts();
+  CAN_message_t req = calRequest;
+  calPending = false;
+  interrupts();
+
+  uint8_t command = req.buf[0];
+  uint8_t param = req.buf[1];
+  uint16_t value = le16(req.buf, 2);
+
+  Calibration next = cal;
+  CalStatus status = CAL_OK;
+  switch (command) {
+  case CAL_SET:
+    status = calibrationSet(next, param, value);
+    break;
+  case CAL_GET:
+    status = param < NUM_CAL_PARAMS ? CAL_OK : CAL_BAD_PARAM;
+    break;
+  case CAL_SAVE:
+    status = saveCalibration(cal) ? CAL_OK : CAL_NOT_SAVED;
+    break;
+  case CAL_DEFAULTS:
+    next = defaultCal;
+    break;
+  default:
+    status = CAL_BAD_COMMAND;
+  }
+  if (status == CAL_OK && (command == CAL_SET || command == CAL_DEFAULTS)) {
+    applyCalibration(next);
+  }
+  LOG_INFO(LOG_SYS, "calibration command %u param %u value %u: status %u",
+           (unsigned)command, (unsigned)param, (unsigned)value,
+           (unsigned)status);
+
+  CAN_message_t reply;
+  memset(&reply, 0, sizeof(reply));
+  reply.id = calId + 1;
+  reply.ext = 1;
+  reply.len = 8;
+  reply.buf[0] = command | 0x80;
+  reply.buf[1] = param;
+  uint16_t now = calibrationGet(cal, param);
+  reply.buf[2] = now & 0xFF;
+  reply.buf[3] = now >> 8;
+  reply.buf[4] = status;
+  Can0.write(reply);
+}
+
+// checkpoints the stats if the engine has run since the last one
+void statsTask(uint32_t) {
+  static uint32_t savedRunMs = 0;
+
+  SessionStats copy = statsSnapshot();
+  uint32_t runMs = copy.zoneMs[ZONE_NORMAL] + copy.zoneMs[ZONE_SHIFT] +
+                   copy.zoneMs[ZONE_OVERREV];
+  if (runMs != savedRunMs) {
+    saveStats(copy);
+    savedRunMs = runMs;
+  }
+}
+
+void printBusStats(void) {
+  static BusStats copy(0); // too big for the stack to be comfortable
+
+  noInterrupts();
+  busStats.roll(micros());
+  copy = busStats;
+  interrupts();
+
+  Serial.printf("bus %lu baud, load %u.%u-%u.%u %%\r\n",
+                (unsigned long)canBaud, copy.loadMin() / 10,
+                copy.loadMin() % 10, copy.loadMax() / 10, copy.loadMax() % 10);
+  Serial.println("id,hz,interval us,jitter us");
+  for (int i = 0; i < BusStats::maxIds; i++) {
+    const IdStats &s = copy.entry(i);
+    if (s.used) {
+      Serial.printf("%lX,%u,%lu,%lu\r\n", (unsigned long)s.id, s.rate,
+                    (unsigned long)s.interval, (unsigned long)s.jitter);
     }
+  }
+  if (copy.untracked()) {
+    Serial.printf("untracked,%lu\r\n", (unsigned long)copy.untracked());
+  }
+}
 
-    delay(70);
+// binary channel stream for a host dashboard, see streamProtocol.h
+extern Task streamT;
+bool streaming = false;
+StreamWriter streamWriter;
+uint32_t streamDropped = 0; // packets the USB buffer had no room for
 
-    for (int i = 0; i < strip.numPixels(); i++) {
-      strip.setPixelColor(i, 40, 0, 0);
-      strip.show();
+void streamTask(uint32_t now) {
+  if (!streaming) {
+    streamWriter.restart();
+    return;
+  }
+
+  DisplayMode mode = displayMode.mode();
+  StreamSample s;
+  sampleSignals(s, (ecuOnline ? STREAM_ECU_ONLINE : 0) |
+                       (engineRunning(mode) ? STREAM_ENG_RUNNING : 0) |
+                       (mode == MODE_TPS ? STREAM_SHOWING_TPS : 0) |
+                       (topWarning() >= 0 ? STREAM_WARNING : 0));
+  if (!streamWriter.add(s, now, streamT.period)) {
+    return;
+  }
+
+  // never block the scheduler on USB, the host sees the gap in seq
+  const StreamPacket &packet = streamWriter.packet();
+  if (Serial.availableForWrite() >= (int)sizeof(packet)) {
+    Serial.write((const uint8_t *)&packet, sizeof(packet));
+  } else {
+    streamDropped++;
+  }
+}
+
+// render cost and the task table, whatever the log level
+void printTiming(void) {
+  Serial.printf("compose cycles %lu max %lu\r\n", (unsigned long)composeCycles,
+                (unsigned long)maxComposeCycles);
+  Serial.printf("show cycles %lu max %lu\r\n", (unsigned long)showCycles,
+                (unsigned long)maxShowCycles);
+
+  for (int i = 0; i < scheduler.count(); i++) {
+    const Task &t = scheduler.task(i);
+    Serial.printf("%s runs %lu overruns %lu skipped %lu jitter %lu us "
+                  "run %lu us\r\n",
+                  t.name, (unsigned long)t.runs, (unsigned long)t.overruns,
+                  (unsigned long)t.skipped, (unsigned long)t.maxJitter,
+                  (unsigned long)t.maxRun);
+  }
+}
+
+// single character commands from the serial monitor
+void commandTask(uint32_t now) {
+  while (Serial.available()) {
+    switch (Serial.read()) {
+    case 'd': // dump the capture in RAM
+      dumpCapture(capture);
+      break;
+    case 'e': // dump the capture saved in EEPROM
+      dumpSavedCapture();
+      break;
+    case 't': // trigger a capture by hand
+      noInterrupts();
+      capture.trigger(TRIGGER_MANUAL, now);
+      interrupts();
+      break;
+    case 'v': // start or stop the binary stream
+      streaming = !streaming;
+      break;
+    case 'b': // print bus load and per ID rates
+      printBusStats();
+      break;
+    case 's': // print the engine usage stats
+      printStats(statsSnapshot());
+      break;
+    case 'm': // print the display mode and transition counts
+      printModes();
+      break;
+    case 'p': // print render cost and task timing
+      printTiming();
+      break;
+    case 'c': // print the calibration
+      printCalibration(cal);
+      Serial.printf("requests dropped %lu, malformed %lu\r\n",
+                    (unsigned long)calDropped, (unsigned long)calMalformed);
+      break;
+    case 'x': // clear the engine usage stats
+      noInterrupts();
+      stats.clear();
+      interrupts();
+      saveStats(statsSnapshot());
+      break;
+    case 'r': // throw away the capture and start recording again
+      noInterrupts();
+      capture.rearm();
+      interrupts();
+      break;
     }
-    strip.clear();
-    delay(1500);
   }
-}
\ No newline at end of file
+}
+
+// only scheduled with LOG_SCHED at debug, see setup()
+void reportTask(uint32_t) {
+  printTiming();
+  scheduler.resetStats();
+}
+
+// periods and deadlines in us, a 0 deadline means the end of the period
+Task checkT = TASK("check", checkTask, 1000, 500, 3);
+Task renderT = TASK("render", renderTask, 10000, 2000, 2);
+Task baudT = TASK("baud", baudTask, baudRetryMs * 1000, 0, 0);
+Task idleT = TASK("idle", idleTask, 100000, 0, 1);
+Task captureT = TASK("capture", captureTask, 10000, 0, 1);
+Task commandT = TASK("command", commandTask, 20000, 0, 0);
+Task statsT = TASK("stats", statsTask, 60000000, 0, 0);
+Task streamT = TASK("stream", streamTask, 1000, 0, 2); // 1 kHz max
+Task calT = TASK("cal", calTask, 20000, 0, 0);
+Task reportT = TASK("report", reportTask, 5000000, 0, 0);
+
+// -------------------------------------------------------------
+void setup(void) {
+  LOG_INFO(LOG_SYS, "online");
+
+  if (!loadStats(stats)) {
+    stats.clear();
+  }
+  stats.sessions++;
+  stats.lastRpmMillis = 0;
+  stats.overRev = false;
+
+  Calibration saved = defaultCal;
+  if (!loadCalibration(saved)) {
+    LOG_INFO(LOG_SYS, "no saved calibration, using defaults");
+  }
+  applyCalibration(saved);
+
+  if (autoBaud) {
+    BaudDetectResult baud = detectBaud(canBaud);
+    canBaud = baud.baud;
+    busStats.setBaud(canBaud);
+
+    canListening = baud.listenOnly;
+
+    LOG_INFO(LOG_CAN, "CAN %s %lu in %lu ms%s",
+             baud.locked ? "locked at" : "not locked, listening at",
+             (unsigned long)canBaud, (unsigned long)baud.lockMillis,
+             baud.sawTraffic && !baud.locked ? " (bus noisy)" : "");
+  } else {
+    Can0.begin(canBaud);
+  }
+
+  // Allow Extended CAN id's through
+  CAN_filter_t allPassFilter;
+  allPassFilter.ext = 1;
+  for (uint8_t filterNum = 1; filterNum < 16;
+       filterNum++) { // original filternum was 8
+    Can0.setFilter(allPassFilter, filterNum);
+  }
+
+  pinMode(13, OUTPUT);
+  digitalWrite(13, HIGH);
+  displayMode.onEnter(MODE_HEARTBEAT, ecuLost);
+  displayMode.onExit(MODE_HEARTBEAT, ecuFound);
+  EcuProfile::subscribe(canDispatch, onEcuFrame);
+  canDispatch.subscribe(calId, onCalFrame);
+
+  Can0.attachObj(&canListener);
+  canListener.attachGeneralHandler();
+
+  // cycle counter for timing the render path
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+
+  strip.begin(pixelPin);
+  strip.show();
+
+  lightShow();
+
+  scheduler.add(checkT);
+  scheduler.add(renderT);
+  scheduler.add(baudT);
+  scheduler.add(idleT);
+  scheduler.add(captureT);
+  scheduler.add(commandT);
+  scheduler.add(statsT);
+  scheduler.add(streamT);
+  scheduler.add(calT);
+#if LOG_ENABLED(LOG_LEVEL_DEBUG, LOG_SCHED)
+  scheduler.add(reportT);
+#endif
+}
+
+void loop(void) { scheduler.runOnce(); }
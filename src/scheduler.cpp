@@ -0,0 +1,83 @@
+/*
+   Cooperative deadline scheduler
+   All times are compared as signed differences so the 32 bit micros()
+   wrap every ~71 minutes doesn't matter.
+ */
+
+#include "scheduler.h"
+
+Scheduler::Scheduler(uint32_t (*clock)(void)) : clock(clock), numTasks(0) {}
+
+bool Scheduler::add(Task &task) {
+  if (numTasks >= maxTasks) {
+    return false;
+  }
+  if (task.deadline == 0) {
+    task.deadline = task.period;
+  }
+  task.nextRelease = clock();
+  tasks[numTasks++] = &task;
+  return true;
+}
+
+bool Scheduler::runOnce() {
+  uint32_t now = clock();
+
+  Task *next = 0;
+  for (int i = 0; i < numTasks; i++) {
+    Task *t = tasks[i];
+    if ((int32_t)(now - t->nextRelease) < 0) {
+      continue;
+    }
+    // highest priority first, then whichever has waited longest
+    if (!next || t->priority > next->priority ||
+        (t->priority == next->priority &&
+         (int32_t)(t->nextRelease - next->nextRelease) < 0)) {
+      next = t;
+    }
+  }
+
+  if (!next) {
+    return false;
+  }
+
+  uint32_t start = clock();
+  next->run(start);
+  uint32_t end = clock();
+
+  uint32_t jitter = start - next->nextRelease;
+  uint32_t runTime = end - start;
+  next->runs++;
+  if (jitter > next->maxJitter) {
+    next->maxJitter = jitter;
+  }
+  if (runTime > next->maxRun) {
+    next->maxRun = runTime;
+  }
+  if (end - next->nextRelease > next->deadline) {
+    next->overruns++;
+  }
+
+  next->nextRelease += next->period;
+  if ((int32_t)(end - next->nextRelease) >= 0) {
+    // fell a whole period behind, drop the backlog instead of bursting
+    next->skipped += (end - next->nextRelease) / next->period + 1;
+    next->nextRelease = end + next->period;
+  }
+
+  return true;
+}
+
+void Scheduler::resync() {
+  uint32_t now = clock();
+  for (int i = 0; i < numTasks; i++) {
+    tasks[i]->nextRelease = now;
+  }
+}
+
+void Scheduler::resetStats() {
+  for (int i = 0; i < numTasks; i++) {
+    Task *t = tasks[i];
+    t->runs = t->overruns = t->skipped = t->maxJitter = t->maxRun = 0;
+  }
+}
@@ -0,0 +1,49 @@
+/*
+   Engine usage statistics
+   Each rpm frame credits the time since the previous one to its bin and
+   zone, so the totals are time, not frame counts.
+ */
+
+#include "sessionStats.h"
+
+#include <string.h>
+
+void SessionStats::clear() {
+  memset(this, 0, sizeof(*this));
+  minVolts = 0xFFFF;
+}
+
+void SessionStats::onRpm(int32_t rpm, uint32_t now, int shiftRpm,
+                         int redline) {
+  uint32_t dt = now - lastRpmMillis;
+  lastRpmMillis = now;
+  if (dt > maxGapMs) {
+    dt = 0; // first frame after a gap
+  }
+
+  int bin = rpm / rpmPerBin;
+  if (bin >= rpmBins) {
+    bin = rpmBins - 1;
+  }
+  rpmMs[bin] += dt;
+
+  uint8_t zone = (rpm > 500) + (rpm > shiftRpm) + (rpm > redline);
+  zoneMs[zone] += dt;
+
+  if (rpm > peakRpm) {
+    peakRpm = rpm;
+  }
+
+  bool over = rpm > redline;
+  overRevs += over && !overRev;
+  overRev = over;
+}
+
+void SessionStats::onVolts(int32_t volts) {
+  if (volts < minVolts) {
+    minVolts = volts;
+  }
+  if (volts > maxVolts) {
+    maxVolts = volts;
+  }
+}
@@ -0,0 +1,61 @@
+/*
+   Decoded signal store
+   Periods are the nominal AN400 rates, PE1 at 50Hz and PE6 at 10Hz. PE2 and
+   PE3 are given the slower period so a 10Hz setting never reads as stale.
+
+   Filters: rpm and tps only get a median of 3, which drops a single bad
+   frame for one sample (20 ms) of lag and keeps the mode thresholds from
+   flapping on it. The slow channels can afford smoothing as well.
+ */
+
+#include "signals.h"
+
+#include <Arduino.h>
+
+static const uint8_t staleHalfPeriods = 5; // flag after 2.5 missed periods
+
+#define SIGNAL(period, median, alpha, rate)                                    \
+  {0, 0, period, false, false, 0, {median, alpha, rate}, {}}
+
+Signal signals[NUM_SIGNALS] = {
+    // period ms, median, iir alpha /256, max rate per s
+    SIGNAL(20, 3, 256, 0),  // SIG_RPM          PE1
+    SIGNAL(20, 3, 256, 0),  // SIG_TPS          PE1
+    SIGNAL(100, 5, 64, 0),  // SIG_VOLTS        PE6
+    SIGNAL(100, 3, 32, 0),  // SIG_AIR_TEMP     PE6
+    SIGNAL(100, 3, 32, 0),  // SIG_COOLANT_TEMP PE6
+    SIGNAL(100, 3, 128, 0), // SIG_LAMBDA       PE2
+    SIGNAL(100, 3, 256, 0), // SIG_OIL_PRESSURE PE3
+};
+
+void updateSignal(SignalId id, int32_t raw, uint32_t now) {
+  Signal &s = signals[id];
+  s.value = filterSample(s.filter, s.filterState, raw, now);
+  s.lastUpdate = now;
+  s.valid = true;
+}
+
+void checkStale(uint32_t now) {
+  for (int i = 0; i < NUM_SIGNALS; i++) {
+    Signal &s = signals[i];
+    if (!s.valid) {
+      continue;
+    }
+    // signed, an update can land after now was sampled
+    int32_t age = (int32_t)(now - s.lastUpdate);
+    bool stale = age > (int32_t)s.periodMs * staleHalfPeriods / 2;
+    if (stale && !s.stale) {
+      s.staleEvents++;
+      // the filter starts again from the first sample after the gap rather
+      // than blending it with samples from before
+      noInterrupts();
+      s.filterState = FilterState();
+      interrupts();
+    }
+    s.stale = stale;
+  }
+}
+
+bool signalFresh(SignalId id) {
+  return signals[id].valid && !signals[id].stale;
+}
@@ -0,0 +1,87 @@
+/*
+   Session statistics persistence and serial export
+ */
+
+#include "statsStore.h"
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "crc16.h"
+#include "eepromLayout.h"
+
+struct StatsSlot {
+  uint32_t seq;
+  SessionStats stats;
+  uint16_t crc; // over seq and stats
+};
+
+static const int numSlots = eepromStatsSize / sizeof(StatsSlot);
+
+static uint32_t lastSeq = 0;
+static int lastSlot = -1;
+
+static int slotAddress(int slot) {
+  return eepromStatsStart + slot * sizeof(StatsSlot);
+}
+
+static uint16_t slotCrc(const StatsSlot &slot) {
+  return crc16(&slot, offsetof(StatsSlot, crc));
+}
+
+bool loadStats(SessionStats &stats) {
+  for (int i = 0; i < numSlots; i++) {
+    StatsSlot slot;
+    EEPROM.get(slotAddress(i), slot);
+    if (slot.crc != slotCrc(slot)) {
+      continue;
+    }
+    if (lastSlot < 0 || (int32_t)(slot.seq - lastSeq) > 0) {
+      lastSeq = slot.seq;
+      lastSlot = i;
+      stats = slot.stats;
+    }
+  }
+  return lastSlot >= 0;
+}
+
+void saveStats(const SessionStats &stats) {
+  StatsSlot slot;
+  memset(&slot, 0, sizeof(slot)); // keep the padding out of the crc
+  slot.seq = ++lastSeq;
+  slot.stats = stats;
+  slot.crc = slotCrc(slot);
+
+  lastSlot = (lastSlot + 1) % numSlots;
+  EEPROM.put(slotAddress(lastSlot), slot);
+}
+
+void printStats(const SessionStats &stats) {
+  Serial.print("sessions ");
+  Serial.println(stats.sessions);
+  Serial.print("peak rpm ");
+  Serial.println(stats.peakRpm);
+  Serial.print("over revs ");
+  Serial.println(stats.overRevs);
+  Serial.print("battery 0.01V min ");
+  Serial.print(stats.minVolts);
+  Serial.print(" max ");
+  Serial.println(stats.maxVolts);
+
+  static const char *const zoneNames[NUM_ZONES] = {"off", "normal", "shift",
+                                                   "overrev"};
+  for (int i = 0; i < NUM_ZONES; i++) {
+    Serial.print("zone ");
+    Serial.print(zoneNames[i]);
+    Serial.print(" ms ");
+    Serial.println(stats.zoneMs[i]);
+  }
+
+  // csv so it pastes straight into a spreadsheet
+  Serial.println("rpm,ms");
+  for (int i = 0; i < SessionStats::rpmBins; i++) {
+    Serial.print(i * SessionStats::rpmPerBin);
+    Serial.print(',');
+    Serial.println(stats.rpmMs[i]);
+  }
+}
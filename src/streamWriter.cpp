@@ -0,0 +1,47 @@
+/*
+   Binary channel stream, the firmware side
+   Values go out as the signal store holds them, truncated to the 16 bit
+   fields of StreamSample.
+ */
+
+#include "streamWriter.h"
+
+#include "signals.h"
+
+bool StreamWriter::add(const StreamSample &sample, uint32_t now,
+                       uint16_t period) {
+  StreamHeader &h = out.header;
+  if (fill == 0) {
+    h.micros = now;
+  }
+  out.samples[fill] = sample;
+
+  if (++fill < samplesPerPacket) {
+    return false;
+  }
+  fill = 0;
+
+  h.sync0 = streamSync0;
+  h.sync1 = streamSync1;
+  h.version = streamVersion;
+  h.count = samplesPerPacket;
+  h.seq = seq++;
+  h.period = period;
+  out.crc = streamCrc(out);
+  return true;
+}
+
+void sampleSignals(StreamSample &s, uint8_t flags) {
+  s.rpm = signals[SIG_RPM].value;
+  s.tps = signals[SIG_TPS].value;
+  s.volts = signals[SIG_VOLTS].value;
+  s.air = signals[SIG_AIR_TEMP].value;
+  s.coolant = signals[SIG_COOLANT_TEMP].value;
+  s.lambda = signals[SIG_LAMBDA].value;
+  s.oil = signals[SIG_OIL_PRESSURE].value;
+  s.flags = flags;
+  s.stale = 0;
+  for (int i = 0; i < NUM_SIGNALS; i++) {
+    s.stale |= !signalFresh((SignalId)i) << i;
+  }
+}
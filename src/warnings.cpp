@@ -0,0 +1,55 @@
+/*
+   Threshold warning engine
+   Low-side rules are flipped to high-side by multiplying through by sign, so
+   every rule runs the same compare.
+ */
+
+#include "warnings.h"
+
+WarningRule warningRules[NUM_WARNINGS] = {
+    // signal        sign raise  clear  ms    running prio colour
+    {SIG_OIL_PRESSURE, -1, 500, 700, 500, true, 4, 255, 0, 255},
+    {SIG_COOLANT_TEMP, 1, 1050, 1000, 1000, false, 3, 255, 0, 0},
+    {SIG_VOLTS, -1, 1150, 1200, 2000, true, 2, 255, 100, 0},
+    {SIG_LAMBDA, 1, 110, 105, 500, true, 1, 0, 0, 255},
+    {SIG_AIR_TEMP, 1, 600, 550, 2000, false, 0, 255, 255, 255},
+};
+
+WarningState warningStates[NUM_WARNINGS];
+
+void evaluateWarnings(bool engRunning, uint32_t now) {
+  for (int i = 0; i < NUM_WARNINGS; i++) {
+    const WarningRule &rule = warningRules[i];
+    WarningState &state = warningStates[i];
+
+    // stale data or an engine-off reading can't raise or hold a warning
+    bool usable = signalFresh(rule.signal) && (engRunning || !rule.runningOnly);
+
+    int32_t value = signals[rule.signal].value * rule.sign;
+    bool pastRaise = usable && value > rule.raise * rule.sign;
+    bool pastClear = !usable || value < rule.clear * rule.sign;
+
+    if (!pastRaise) {
+      state.pending = false;
+    } else if (!state.pending) {
+      state.pending = true;
+      state.since = now;
+    }
+
+    bool raise = !state.active && state.pending &&
+                 now - state.since >= rule.minMs;
+    state.events += raise;
+    state.active = (state.active && !pastClear) || raise;
+  }
+}
+
+int topWarning(void) {
+  int top = -1;
+  for (int i = 0; i < NUM_WARNINGS; i++) {
+    if (warningStates[i].active &&
+        (top < 0 || warningRules[i].priority > warningRules[top].priority)) {
+      top = i;
+    }
+  }
+  return top;
+}
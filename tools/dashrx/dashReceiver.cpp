@@ -0,0 +1,94 @@
+/*
+   Host side receiver for the firmware's binary channel stream
+ */
+
+#include "dashReceiver.h"
+
+#include <string.h>
+
+void DashReceiver::feed(const uint8_t *data, size_t len, uint64_t hostMicros) {
+  totals.bytes += len;
+  pending.insert(pending.end(), data, data + len);
+  parse(hostMicros);
+}
+
+void DashReceiver::parse(uint64_t hostMicros) {
+  size_t pos = 0;
+  const size_t size = sizeof(StreamPacket);
+
+  while (pending.size() - pos >= size) {
+    const uint8_t *p = pending.data() + pos;
+    if (p[0] != streamSync0 || p[1] != streamSync1) {
+      pos++;
+      totals.skippedBytes++;
+      continue;
+    }
+
+    StreamPacket packet;
+    memcpy(&packet, p, size);
+    if (packet.header.version != streamVersion ||
+        packet.header.count > samplesPerPacket ||
+        packet.crc != streamCrc(packet)) {
+      // a sync pattern inside something else, slide past it
+      totals.crcErrors++;
+      pos++;
+      totals.skippedBytes++;
+      continue;
+    }
+
+    accept(packet, hostMicros);
+    pos += size;
+  }
+
+  pending.erase(pending.begin(), pending.begin() + pos);
+}
+
+void DashReceiver::accept(const StreamPacket &packet, uint64_t hostMicros) {
+  const StreamHeader &h = packet.header;
+
+  if (haveSeq) {
+    totals.lostPackets += (uint16_t)(h.seq - lastSeq - 1);
+  }
+  haveSeq = true;
+  lastSeq = h.seq;
+  totals.packets++;
+
+  // the last sample is the freshest, time the packet from it
+  uint32_t lastMicros = h.micros + (h.count - 1) * h.period;
+  if (haveOffset) {
+    deviceTime += (int32_t)(lastMicros - lastDeviceMicros); // wraps cleanly
+  } else {
+    deviceTime = lastMicros;
+  }
+  lastDeviceMicros = lastMicros;
+  int64_t offset = (int64_t)hostMicros - deviceTime;
+  if (!haveOffset || offset < minOffset) {
+    minOffset = offset;
+    haveOffset = true;
+  }
+  uint64_t latency = offset - minOffset;
+  totals.latencySamples++;
+  totals.latencySumUs += latency;
+  if (latency > totals.latencyMaxUs) {
+    totals.latencyMaxUs = latency;
+  }
+
+  for (int i = 0; i < h.count; i++) {
+    DashSample sample;
+    sample.deviceMicros = h.micros + i * h.period;
+    sample.hostMicros = hostMicros;
+    sample.values = packet.samples[i];
+    totals.samples++;
+    if (onSample) {
+      onSample(sample);
+    }
+  }
+}
+
+void DashReceiver::resetLatency() {
+  haveOffset = false;
+  haveSeq = false;
+  totals.latencySamples = 0;
+  totals.latencySumUs = 0;
+  totals.latencyMaxUs = 0;
+}
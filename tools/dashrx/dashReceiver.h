@@ -0,0 +1,66 @@
+/*
+   Host side receiver for the firmware's binary channel stream
+   Feed it whatever bytes come off the serial port, in any chunking. It finds
+   packets by their sync bytes and CRC, so text logging mixed into the
+   stream is skipped over, and hands each sample to a callback.
+ */
+
+#ifndef DASH_RECEIVER_H
+#define DASH_RECEIVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "streamProtocol.h"
+
+struct DashSample {
+  uint32_t deviceMicros; // when the firmware took it
+  uint64_t hostMicros;   // when the packet holding it arrived
+  StreamSample values;
+};
+
+struct DashStats {
+  uint64_t bytes = 0;
+  uint64_t packets = 0;
+  uint64_t samples = 0;
+  uint64_t lostPackets = 0; // from gaps in the sequence number
+  uint64_t crcErrors = 0;
+  uint64_t skippedBytes = 0; // not part of any packet, e.g. text logs
+
+  // arrival time minus device time, relative to the smallest seen. the
+  // smallest is the best case path, so this is latency above best case
+  uint64_t latencySamples = 0;
+  double latencySumUs = 0;
+  uint64_t latencyMaxUs = 0;
+};
+
+class DashReceiver {
+public:
+  typedef std::function<void(const DashSample &)> Callback;
+
+  explicit DashReceiver(Callback onSample) : onSample(onSample) {}
+
+  void feed(const uint8_t *data, size_t len, uint64_t hostMicros);
+
+  const DashStats &stats() const { return totals; }
+  void resetLatency(); // call after the device resets its clock
+
+private:
+  void parse(uint64_t hostMicros);
+  void accept(const StreamPacket &packet, uint64_t hostMicros);
+
+  Callback onSample;
+  std::vector<uint8_t> pending;
+  DashStats totals;
+  bool haveSeq = false;
+  uint16_t lastSeq = 0;
+  bool haveOffset = false;
+  int64_t minOffset = 0;
+  int64_t deviceTime = 0; // device micros() unwrapped, it wraps every ~71 min
+  uint32_t lastDeviceMicros = 0;
+};
+
+#endif
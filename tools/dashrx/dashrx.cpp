@@ -0,0 +1,106 @@
+/*
+   dashrx, live view of the firmware's binary channel stream
+   Opens the Teensy's serial port, turns the stream on and prints the
+   latest values with throughput, gaps and latency once a second.
+
+   build: g++ -O2 -std=c++11 -Iinclude tools/dashrx/dashrx.cpp \
+            tools/dashrx/dashReceiver.cpp -o dashrx
+   run:   ./dashrx /dev/ttyACM0
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dashReceiver.h"
+
+static uint64_t nowMicros() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int openPort(const char *path) {
+  int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+
+  // raw bytes, no line discipline. the baud is ignored by USB serial
+  termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <serial port> [--no-start]\n", argv[0]);
+    return 2;
+  }
+
+  int fd = openPort(argv[1]);
+  if (fd < 0) {
+    return 1;
+  }
+
+  // 'v' toggles the stream on the firmware side
+  bool start = !(argc > 2 && strcmp(argv[2], "--no-start") == 0);
+  if (start && write(fd, "v", 1) != 1) {
+    perror("write");
+  }
+
+  DashSample latest = {};
+  DashReceiver rx([&](const DashSample &s) { latest = s; });
+
+  uint64_t reportAt = nowMicros() + 1000000;
+  DashStats last = rx.stats();
+  uint8_t buf[4096];
+
+  for (;;) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0) {
+      perror("read");
+      return 1;
+    }
+    if (n == 0) {
+      break;
+    }
+    uint64_t now = nowMicros();
+    rx.feed(buf, n, now);
+
+    if (now >= reportAt) {
+      const DashStats &s = rx.stats();
+      const StreamSample &v = latest.values;
+      double avgLatency = s.latencySamples
+                              ? s.latencySumUs / s.latencySamples
+                              : 0;
+
+      printf("rpm %5u tps %4.1f%% %5.2fV clt %5.1fC air %5.1fC "
+             "flags %02x stale %02x | %llu samples/s %llu B/s lost %llu "
+             "crc %llu latency avg %.0f max %llu us\n",
+             v.rpm, v.tps / 10.0, v.volts / 100.0, v.coolant / 10.0,
+             v.air / 10.0, v.flags, v.stale,
+             (unsigned long long)(s.samples - last.samples),
+             (unsigned long long)(s.bytes - last.bytes),
+             (unsigned long long)s.lostPackets,
+             (unsigned long long)s.crcErrors, avgLatency,
+             (unsigned long long)s.latencyMaxUs);
+      fflush(stdout);
+
+      last = s;
+      reportAt += 1000000;
+    }
+  }
+
+  close(fd);
+  return 0;
+}
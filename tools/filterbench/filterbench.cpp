@@ -0,0 +1,179 @@
+/*
+   filterbench, characterises the channel filters in signals.cpp
+   Decodes a printFrame() trace with the firmware's ECU profile and runs
+   every channel through its configured filter, then prints per channel
+     noise       mean absolute second difference, raw and filtered, and
+                 how much of it the filter took out
+     outliers    samples more than a channel's glitch size away from both
+                 neighbours, raw and after filtering
+     crossings   times rpm crosses 500 and tps 20 %, the display mode
+                 thresholds, raw and filtered
+   and from synthetic input, independent of the trace
+     step        ms for a 0 to 1000 step to reach 900
+     spike       how much of a one sample 1000 spike gets through
+
+   build: g++ -O2 -std=c++11 -Iinclude -Itools/replay/host \
+            tools/filterbench/filterbench.cpp src/filters.cpp src/signals.cpp \
+            -o filterbench
+          (signals.cpp masks interrupts, the replay's Arduino.h stands in)
+   run:   ./pe3gen --seconds 60 --corrupt 10 > trace.txt
+          ./filterbench trace.txt
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "ecuProfiles.h"
+#include "signals.h"
+
+int Pe3Profile::oilPressureInput = 0;
+
+static const char *const names[NUM_SIGNALS] = {
+    "rpm", "tps", "volts", "air", "coolant", "lambda", "oil"};
+
+// a sample this far from both neighbours is a glitch, in channel units
+static const int32_t glitchSize[NUM_SIGNALS] = {1000, 100, 100, 50,
+                                                50,   20,  500};
+
+// display mode thresholds, 0 where there isn't one
+static const int32_t modeThreshold[NUM_SIGNALS] = {500, 200, 0, 0, 0, 0, 0};
+
+struct Series {
+  std::vector<uint32_t> t;
+  std::vector<int32_t> raw, filtered;
+};
+
+static Series series[NUM_SIGNALS];
+static FilterState states[NUM_SIGNALS];
+static uint32_t nowMs;
+
+struct BenchSink {
+  void set(SignalId id, int32_t value) {
+    Series &s = series[id];
+    s.t.push_back(nowMs);
+    s.raw.push_back(value);
+    s.filtered.push_back(
+        filterSample(signals[id].filter, states[id], value, nowMs));
+  }
+};
+
+static double noise(const std::vector<int32_t> &v) {
+  if (v.size() < 3) return 0;
+  double sum = 0;
+  for (size_t i = 2; i < v.size(); i++) {
+    sum += fabs((double)v[i] - 2.0 * v[i - 1] + v[i - 2]);
+  }
+  return sum / (v.size() - 2);
+}
+
+static int outliers(const std::vector<int32_t> &v, int32_t size) {
+  int n = 0;
+  for (size_t i = 1; i + 1 < v.size(); i++) {
+    if (labs(v[i] - v[i - 1]) > size && labs(v[i] - v[i + 1]) > size) n++;
+  }
+  return n;
+}
+
+static int crossings(const std::vector<int32_t> &v, int32_t threshold) {
+  int n = 0;
+  for (size_t i = 1; i < v.size(); i++) {
+    n += (v[i] > threshold) != (v[i - 1] > threshold);
+  }
+  return n;
+}
+
+// ms until a 0 to 1000 step reads 900, -1 if it never does
+static int stepMs(int id) {
+  const FilterConfig &config = signals[id].filter;
+  FilterState state = {};
+  uint32_t period = signals[id].periodMs;
+  uint32_t t = 0;
+  for (int i = 0; i < 20; i++, t += period) filterSample(config, state, 0, t);
+  for (int i = 0; i < 500; i++, t += period) {
+    if (filterSample(config, state, 1000, t) >= 900) return i * period;
+  }
+  return -1;
+}
+
+// peak output, in %, for a single 1000 sample in a run of zeros
+static int spikePct(int id) {
+  const FilterConfig &config = signals[id].filter;
+  FilterState state = {};
+  uint32_t period = signals[id].periodMs;
+  uint32_t t = 0;
+  int32_t peak = 0;
+  for (int i = 0; i < 60; i++, t += period) {
+    int32_t y = filterSample(config, state, i == 20 ? 1000 : 0, t);
+    if (y > peak) peak = y;
+  }
+  return peak / 10;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <trace> [--ms]\n", argv[0]);
+    return 2;
+  }
+  bool ms = argc > 2 && !strcmp(argv[2], "--ms");
+
+  FILE *f = fopen(argv[1], "r");
+  if (!f) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  char line[256];
+  uint32_t frames = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char *tag = strstr(line, "ID: ");
+    if (!tag) continue;
+
+    char *p;
+    long ts = strtol(line, &p, 10);
+    nowMs = (p != line && p <= tag) ? (ms ? ts : ts / 1000) : frames;
+
+    uint32_t id = strtoul(tag + 4, &p, 16);
+    p = strstr(p, "Data:");
+    if (!p) continue;
+    p += 5;
+    uint8_t buf[8] = {0};
+    for (int len = 0; len < 8; len++) {
+      char *q;
+      unsigned long b = strtoul(p, &q, 16);
+      if (q == p) break;
+      buf[len] = b;
+      p = q;
+    }
+
+    BenchSink sink;
+    EcuProfile::decode(id, buf, sink);
+    frames++;
+  }
+  fclose(f);
+
+  printf("%u frames\n", frames);
+  printf("%-8s %7s %9s %9s %6s %9s %11s %7s %6s\n", "channel", "samples",
+         "noise raw", "filtered", "dB", "outliers", "crossings", "step", "spike");
+  for (int i = 0; i < NUM_SIGNALS; i++) {
+    const Series &s = series[i];
+    double nRaw = noise(s.raw), nFilt = noise(s.filtered);
+    double db = nRaw > 0 && nFilt > 0 ? 20 * log10(nRaw / nFilt) : 0;
+
+    char cross[24] = "-";
+    if (modeThreshold[i]) {
+      snprintf(cross, sizeof(cross), "%d/%d", crossings(s.raw, modeThreshold[i]),
+               crossings(s.filtered, modeThreshold[i]));
+    }
+    char out[24];
+    snprintf(out, sizeof(out), "%d/%d", outliers(s.raw, glitchSize[i]),
+             outliers(s.filtered, glitchSize[i]));
+
+    printf("%-8s %7zu %9.1f %9.1f %6.1f %9s %11s %5dms %5d%%\n", names[i],
+           s.raw.size(), nRaw, nFilt, db, out, cross, stepMs(i), spikePct(i));
+  }
+  return 0;
+}
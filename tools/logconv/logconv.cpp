@@ -0,0 +1,273 @@
+/*
+   logconv, turns printFrame() captures into per-channel columns
+   Reads "ID: <hex> Data: <hex bytes>" lines, optionally led by a timestamp
+   as in the event capture dumps, and decodes them with the same profile
+   the firmware is built with (ecuProfiles.h, -DECU_PROFILE to change it).
+
+   The file is memory mapped and cut into one chunk per core at line
+   boundaries. Each thread parses its chunk into its own columns and the
+   columns are joined in file order afterwards, so the output is the same
+   whatever the thread count.
+
+   Output is one file per channel in the output directory, either raw
+   little endian int32 pairs (frame number, value) or csv. Frame numbers
+   count parsed frames from the start of the file; when the lines carry a
+   timestamp it goes in its own "time" column keyed the same way. Times are
+   int64, since us timestamps pass int32 after about 35 minutes, so a
+   binary time row is an int32 frame and an int64 time, 12 bytes packed.
+
+   build: g++ -O2 -std=c++11 -pthread -Iinclude tools/logconv/logconv.cpp \
+            -o logconv
+   run:   ./logconv capture.txt outdir [--csv] [--threads N]
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ecuProfiles.h"
+
+int Pe3Profile::oilPressureInput = 0;
+
+static const char *const channelNames[NUM_SIGNALS] = {
+    "rpm", "tps", "volts", "air_temp", "coolant_temp", "lambda", "oil_pressure"};
+
+struct Point {
+  int32_t frame;
+  int32_t value;
+};
+
+struct TimePoint {
+  int32_t frame;
+  int64_t value;
+} __attribute__((packed));
+
+struct Columns {
+  std::vector<Point> channel[NUM_SIGNALS];
+  std::vector<TimePoint> time; // leading timestamp, if the line had one
+  uint64_t frames = 0;   // lines that parsed as frames
+  uint64_t rejected = 0; // lines that didn't
+};
+
+// collects what the profile decoded, like SignalSink in the firmware
+struct ColumnSink {
+  Columns *out;
+  int32_t frame;
+  void set(SignalId id, int32_t value) {
+    out->channel[id].push_back(Point{frame, value});
+  }
+};
+
+static inline int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// parses hex digits at p, returns false if there were none
+static inline bool parseHex(const char *&p, const char *end, uint32_t &v) {
+  const char *start = p;
+  v = 0;
+  int d;
+  while (p < end && (d = hexDigit(*p)) >= 0) {
+    v = (v << 4) | d;
+    p++;
+  }
+  return p != start;
+}
+
+static inline void skipSpaces(const char *&p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) p++;
+}
+
+static bool parseLine(const char *p, const char *end, uint32_t &id,
+                      uint8_t *buf, uint8_t &len, bool &timed, int64_t &t) {
+  // skip anything before "ID: ", e.g. a capture timestamp
+  const char *tag = (const char *)memmem(p, end - p, "ID: ", 4);
+  if (!tag) return false;
+
+  char *after;
+  t = strtoll(p, &after, 10);
+  timed = after != p && after <= tag;
+
+  p = tag + 4;
+  if (!parseHex(p, end, id)) return false;
+
+  skipSpaces(p, end);
+  if (end - p < 5 || memcmp(p, "Data:", 5) != 0) return false;
+  p += 5;
+
+  len = 0;
+  memset(buf, 0, 8);
+  for (;;) {
+    skipSpaces(p, end);
+    uint32_t byte;
+    if (len == 8 || !parseHex(p, end, byte)) break;
+    if (byte > 0xFF) return false;
+    buf[len++] = byte;
+  }
+  return true;
+}
+
+static void parseChunk(const char *begin, const char *end, Columns *out) {
+  const char *p = begin;
+  while (p < end) {
+    const char *eol = (const char *)memchr(p, '\n', end - p);
+    if (!eol) eol = end;
+
+    uint32_t id;
+    uint8_t buf[8], len;
+    bool timed;
+    int64_t t;
+    if (parseLine(p, eol, id, buf, len, timed, t)) {
+      if (timed) out->time.push_back(TimePoint{(int32_t)out->frames, t});
+      ColumnSink sink = {out, (int32_t)out->frames};
+      EcuProfile::decode(id, buf, sink);
+      out->frames++;
+    } else if (eol - p > 1) {
+      out->rejected++;
+    }
+    p = eol + 1;
+  }
+}
+
+static const std::vector<Point> &column(const Columns &c, int channel) {
+  return c.channel[channel];
+}
+static const std::vector<TimePoint> &column(const Columns &c, TimePoint *) {
+  return c.time;
+}
+
+// Key is a channel number, or a TimePoint pointer for the timestamp column
+template <typename P, typename Key>
+static bool writeColumn(const std::string &dir, const char *name, Key key,
+                        const std::vector<Columns> &parts,
+                        const std::vector<int32_t> &firstFrame, bool csv) {
+  std::string path = dir + "/" + name + (csv ? ".csv" : ".bin");
+  FILE *f = fopen(path.c_str(), "wb");
+  if (!f) {
+    perror(path.c_str());
+    return false;
+  }
+  if (csv) fprintf(f, "frame,%s\n", name);
+
+  for (size_t i = 0; i < parts.size(); i++) {
+    const std::vector<P> &points = column(parts[i], key);
+    if (csv) {
+      for (const P &pt : points) {
+        fprintf(f, "%d,%lld\n", pt.frame + firstFrame[i],
+                (long long)pt.value);
+      }
+    } else {
+      std::vector<P> shifted(points);
+      for (P &pt : shifted) pt.frame += firstFrame[i];
+      fwrite(shifted.data(), sizeof(P), shifted.size(), f);
+    }
+  }
+  return fclose(f) == 0;
+}
+
+static double seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <capture> <outdir> [--csv] [--threads N]\n",
+            argv[0]);
+    return 2;
+  }
+
+  bool csv = false;
+  unsigned threads = std::thread::hardware_concurrency();
+  for (int i = 3; i < argc; i++) {
+    if (!strcmp(argv[i], "--csv")) {
+      csv = true;
+    } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    }
+  }
+  if (threads == 0) threads = 1;
+
+  int fd = open(argv[1], O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  size_t size = st.st_size;
+  if (size == 0) {
+    fprintf(stderr, "%s is empty\n", argv[1]);
+    return 1;
+  }
+
+  const char *data =
+      (const char *)mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  madvise((void *)data, size, MADV_SEQUENTIAL);
+
+  double start = seconds();
+
+  // chunk boundaries moved forward to the next line start
+  std::vector<const char *> cuts;
+  cuts.push_back(data);
+  for (unsigned i = 1; i < threads; i++) {
+    const char *cut = data + size * i / threads;
+    const char *nl = (const char *)memchr(cut, '\n', data + size - cut);
+    cut = nl ? nl + 1 : data + size;
+    if (cut > cuts.back()) cuts.push_back(cut);
+  }
+  cuts.push_back(data + size);
+
+  std::vector<Columns> parts(cuts.size() - 1);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i + 1 < cuts.size(); i++) {
+    workers.emplace_back(parseChunk, cuts[i], cuts[i + 1], &parts[i]);
+  }
+  for (std::thread &w : workers) w.join();
+
+  double parsed = seconds();
+
+  std::vector<int32_t> firstFrame(parts.size());
+  uint64_t frames = 0, rejected = 0;
+  for (size_t i = 0; i < parts.size(); i++) {
+    firstFrame[i] = frames;
+    frames += parts[i].frames;
+    rejected += parts[i].rejected;
+  }
+
+  bool ok = writeColumn<TimePoint>(argv[2], "time", (TimePoint *)0, parts,
+                                   firstFrame, csv);
+  for (int c = 0; c < NUM_SIGNALS; c++) {
+    ok &= writeColumn<Point>(argv[2], channelNames[c], c, parts, firstFrame,
+                             csv);
+  }
+
+  double done = seconds();
+  double parseTime = parsed - start;
+  fprintf(stderr,
+          "%llu frames, %llu other lines, %zu bytes, %zu threads\n"
+          "parse %.3f s (%.0f MB/s, %.1f M frames/s), total %.3f s\n",
+          (unsigned long long)frames, (unsigned long long)rejected, size,
+          parts.size(), parseTime, size / parseTime / 1e6,
+          frames / parseTime / 1e6, done - start);
+
+  munmap((void *)data, size);
+  close(fd);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,377 @@
+/*
+   pe3gen, synthetic PE3 traffic
+   Simulates a CAN bus carrying the PE3's broadcast frames plus whatever
+   else is on the car, and prints what a node on that bus would receive in
+   the timestamped printFrame() format ("<us> ID: <hex> Data: <hex> ...").
+   The output can be saved as a recorded file, fed to tools/logconv, or
+   piped into the host replay.
+
+   Every sender is a source with a period and one transmit buffer. Frames
+   go out one at a time, lowest ID first among those waiting, and take
+   their worst case length on the wire (stuffing as BusStats counts it),
+   so the receive times show the queueing a loaded bus causes. A source
+   whose last frame has not gone out by its next period loses that frame.
+
+   profiles   idle       engine idling
+              pull       full throttle pulls through the gears
+              limiter    bouncing off the rev limiter
+              mixed      idle, pull, limiter and a lift off, repeated
+              throttle   engine off with the ECU up: a throttle blip, a
+                         sweep open and shut, then a coolant heat soak
+
+   build: g++ -O2 -std=c++11 -Iinclude tools/pe3gen/pe3gen.cpp -o pe3gen
+   run:   ./pe3gen --profile mixed --seconds 60 --load 100 > trace.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "ecuProfiles.h"
+
+struct Options {
+  const char *profile = "mixed";
+  uint32_t seconds = 30;
+  uint32_t baud = Pe3Profile::defaultBaud;
+  uint32_t load = 0;     // % of the bus, noise frames fill up to it
+  uint32_t jitter = 0;   // +- us on each PE3 transmit time
+  uint32_t drop = 0;     // 0.1 % of PE3 frames that are never sent
+  uint32_t noiseIds = 8; // other senders sharing the bus
+  uint32_t corrupt = 0;  // 0.1 % of PE3 frames with random payloads
+  uint32_t redline = 11250;
+  uint32_t seed = 1;
+};
+
+// xorshift, so a seed always gives the same trace
+static uint32_t rngState;
+static uint32_t rng() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+static int32_t rngRange(int32_t lo, int32_t hi) {
+  return lo + (int32_t)(rng() % (uint32_t)(hi - lo + 1));
+}
+
+// -------------------------------------------------------------
+// engine model
+
+struct Engine {
+  int32_t rpm;   // 1 rpm
+  int32_t tps;   // 0.1 %
+  int32_t volts; // 0.01 V
+  int32_t lambda;
+  int32_t coolant; // 0.1 C
+  int32_t air;
+  int32_t oil; // mV
+};
+
+static const int32_t idleRpm = 1500;
+
+// t is in us from the start of the phase
+static void idle(uint64_t t, Engine &e) {
+  e.rpm = idleRpm + (int32_t)(t / 1000 % 400) / 4 - 50; // slow hunt
+  e.tps = 20;
+}
+
+// 4 s per gear from 6000 to the redline, shift drops 30 %
+static void pull(uint64_t t, Engine &e, uint32_t redline) {
+  uint32_t gearMicros = 4000000;
+  uint32_t inGear = t % gearMicros;
+  int32_t start = t < gearMicros ? 6000 : redline * 7 / 10;
+  e.rpm = start + (int32_t)((uint64_t)(redline - start) * inGear / gearMicros);
+  e.tps = inGear < 150000 ? 0 : 1000; // lift for the shift
+}
+
+// hard cut, 300 rpm under to 100 over at 10 Hz
+static void limiter(uint64_t t, Engine &e, uint32_t redline) {
+  uint32_t phase = t % 100000;
+  e.rpm = phase < 50000 ? redline + 100 - phase * 400 / 50000
+                        : redline - 300 + (phase - 50000) * 400 / 50000;
+  e.tps = 1000;
+}
+
+static void liftOff(uint64_t t, Engine &e, uint32_t redline) {
+  int32_t drop = (int32_t)(t / 1000) * 2; // 2000 rpm/s
+  e.rpm = (int32_t)redline - drop < idleRpm ? idleRpm : redline - drop;
+  e.tps = 0;
+}
+
+// engine off, a blip shorter than the display's mode dwell at 1 s, a 2 s
+// sweep open and 2 s back from 2 s
+static void throttle(uint64_t t, Engine &e) {
+  e.rpm = 0;
+  if (t >= 1000000 && t < 1100000) {
+    e.tps = 500;
+  } else if (t >= 2000000 && t < 6000000) {
+    uint32_t ms = (t - 2000000) / 1000;
+    e.tps = ms < 2000 ? ms / 2 : (4000 - ms) / 2;
+  } else {
+    e.tps = 0;
+  }
+}
+
+// coolant over 105 C from 7 s to 10 s, long enough to raise the warning
+static int32_t heatSoak(uint64_t t) {
+  return t >= 7000000 && t < 10000000 ? 400 : 0;
+}
+
+static void engineAt(const Options &o, uint64_t t, Engine &e) {
+  if (!strcmp(o.profile, "idle")) {
+    idle(t, e);
+  } else if (!strcmp(o.profile, "pull")) {
+    pull(t, e, o.redline);
+  } else if (!strcmp(o.profile, "limiter")) {
+    limiter(t, e, o.redline);
+  } else if (!strcmp(o.profile, "throttle")) {
+    throttle(t, e);
+  } else {
+    // 5 s idle, 16 s pull, 3 s limiter, 5 s lift off
+    uint32_t t0 = t % 29000000;
+    if (t0 < 5000000) {
+      idle(t0, e);
+    } else if (t0 < 21000000) {
+      pull(t0 - 5000000, e, o.redline);
+    } else if (t0 < 24000000) {
+      limiter(t0 - 21000000, e, o.redline);
+    } else {
+      liftOff(t0 - 24000000, e, o.redline);
+    }
+  }
+
+  // everything else drifts slowly with a little noise
+  uint32_t s = t / 1000000;
+  e.volts = 1380 - (e.rpm < 1000 ? 120 : 0) + rngRange(-5, 5);
+  e.lambda = (e.tps > 800 ? 88 : 100) + rngRange(-2, 2);
+  e.coolant = 700 + (s < 300 ? s : 300) + rngRange(-2, 2);
+  e.air = 300 + rngRange(-3, 3);
+  e.oil = 500 + e.rpm / 4 + rngRange(-20, 20);
+  if (!strcmp(o.profile, "throttle")) e.coolant += heatSoak(t);
+}
+
+// -------------------------------------------------------------
+// frames, laid out as Pe3Profile::decode reads them
+
+struct Frame {
+  uint32_t id;
+  bool ext;
+  uint8_t len;
+  uint8_t buf[8];
+};
+
+static void put16(uint8_t *buf, int i, int32_t v) {
+  buf[i] = v & 0xFF;
+  buf[i + 1] = (v >> 8) & 0xFF;
+}
+
+static Frame pe3Frame(uint32_t id, const Engine &e) {
+  Frame f = {id, true, 8, {0}};
+  switch (id) {
+  case Pe3Profile::PE1:
+    put16(f.buf, 0, e.rpm);
+    put16(f.buf, 2, e.tps);
+    break;
+  case Pe3Profile::PE2:
+    put16(f.buf, 4, e.lambda);
+    break;
+  case Pe3Profile::PE3:
+    for (int i = 0; i < 4; i++) put16(f.buf, i * 2, e.oil);
+    break;
+  case Pe3Profile::PE6:
+    put16(f.buf, 0, e.volts);
+    put16(f.buf, 2, e.air);
+    put16(f.buf, 4, e.coolant);
+    f.buf[6] = 1; // celsius
+    break;
+  }
+  return f;
+}
+
+// worst case bits on the wire, as BusStats::loadMax counts them
+static uint32_t frameBits(bool ext, uint8_t len) {
+  uint32_t data = len * 8;
+  return (ext ? 67 : 47) + data + ((ext ? 54 : 34) + data - 1) / 4;
+}
+
+// lower wins arbitration; an 11 bit ID beats a 29 bit one with the same
+// top 11 bits
+static uint32_t arbitration(const Frame &f) {
+  return f.ext ? (f.id << 1) | 1 : f.id << 19;
+}
+
+// -------------------------------------------------------------
+// bus
+
+struct Source {
+  uint32_t id;
+  bool ext;
+  bool pe3;
+  uint32_t period; // us
+  uint64_t slot;   // nominal time of the next transmit, us
+  uint64_t next;   // slot moved by the jitter
+  bool waiting;    // transmit buffer full
+  uint64_t queued; // when the waiting frame was queued
+  Frame frame;
+};
+
+struct Totals {
+  uint64_t sent, pe3Sent, dropped, overrun, corrupted, bits;
+  uint32_t worstLatency; // queued to received, PE3 only
+};
+
+int main(int argc, char **argv) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : 0;
+    if (!v) {
+      fprintf(stderr, "%s needs a value\n", a);
+      return 2;
+    }
+    i++;
+    if (!strcmp(a, "--profile")) o.profile = v;
+    else if (!strcmp(a, "--seconds")) o.seconds = atoi(v);
+    else if (!strcmp(a, "--baud")) o.baud = atoi(v);
+    else if (!strcmp(a, "--load")) o.load = atoi(v);
+    else if (!strcmp(a, "--jitter")) o.jitter = atoi(v);
+    else if (!strcmp(a, "--drop")) o.drop = atoi(v);
+    else if (!strcmp(a, "--noise")) o.noiseIds = atoi(v);
+    else if (!strcmp(a, "--corrupt")) o.corrupt = atoi(v);
+    else if (!strcmp(a, "--redline")) o.redline = atoi(v);
+    else if (!strcmp(a, "--seed")) o.seed = atoi(v);
+    else {
+      fprintf(stderr,
+              "usage: %s [--profile idle|pull|limiter|mixed|throttle]\n"
+              "  [--seconds N] [--baud B] [--load %%] [--jitter us]\n"
+              "  [--drop 0.1%%] [--noise ids] [--corrupt 0.1%%]\n"
+              "  [--redline rpm] [--seed N]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  rngState = o.seed ? o.seed : 1;
+
+  // PE3 rates match the periods in signals.cpp
+  std::vector<Source> sources;
+  Source pe[] = {{Pe3Profile::PE1, true, true, 20000},
+                 {Pe3Profile::PE2, true, true, 100000},
+                 {Pe3Profile::PE3, true, true, 100000},
+                 {Pe3Profile::PE6, true, true, 100000}};
+  uint64_t pe3Bits = 0;
+  for (Source &s : pe) {
+    sources.push_back(s);
+    pe3Bits += (uint64_t)frameBits(true, 8) * 1000000 / s.period;
+  }
+
+  // noise senders split whatever load the PE3 leaves, with random IDs of
+  // both lengths so some win arbitration against the PE3 and some lose
+  uint64_t target = (uint64_t)o.baud * o.load / 100;
+  if (o.noiseIds && target > pe3Bits) {
+    uint64_t each = (target - pe3Bits) / o.noiseIds;
+    for (uint32_t i = 0; i < o.noiseIds; i++) {
+      Source s = {};
+      s.ext = rng() & 1;
+      s.id = s.ext ? rng() & 0x1FFFFFFF : rng() & 0x7FF;
+      uint64_t period = frameBits(s.ext, 8) * 1000000ull / (each ? each : 1);
+      s.period = period < 1 ? 1 : period > 1000000 ? 1000000 : period;
+      s.slot = s.next = rng() % s.period;
+      sources.push_back(s);
+    }
+  }
+
+  Totals tot = {};
+  Engine e = {};
+  // us in 64 bits, a soak run passes 2^32 us after 71 minutes
+  uint64_t end = o.seconds * 1000000ull;
+  uint64_t now = 0; // bus time, ns so short frames at 1M add up
+
+  while (now / 1000 < end) {
+    uint64_t us = now / 1000;
+
+    // load every source that is due
+    for (Source &s : sources) {
+      while (s.next <= us) {
+        uint64_t due = s.next;
+        s.slot += s.period;
+        s.next = s.slot;
+        if (s.pe3 && o.jitter) {
+          int32_t j = rngRange(-(int32_t)o.jitter, o.jitter);
+          s.next = j < 0 && s.slot < (uint64_t)-j ? 0 : s.slot + j;
+          if (s.next <= due) s.next = due + 1;
+        }
+        if (s.pe3 && (uint32_t)rngRange(0, 999) < o.drop) {
+          tot.dropped++;
+          continue;
+        }
+        if (s.waiting) {
+          tot.overrun++; // still hadn't won the bus
+        }
+        if (s.pe3) {
+          engineAt(o, due, e);
+          s.frame = pe3Frame(s.id, e);
+          if ((uint32_t)rngRange(0, 999) < o.corrupt) {
+            for (int b = 0; b < 8; b++) s.frame.buf[b] = rng();
+            tot.corrupted++;
+          }
+        } else {
+          s.frame.id = s.id;
+          s.frame.ext = s.ext;
+          s.frame.len = 8;
+          for (int b = 0; b < 8; b++) s.frame.buf[b] = rng();
+        }
+        s.waiting = true;
+        s.queued = due;
+      }
+    }
+
+    // arbitration among the waiting frames
+    Source *winner = 0;
+    for (Source &s : sources) {
+      if (s.waiting &&
+          (!winner || arbitration(s.frame) < arbitration(winner->frame))) {
+        winner = &s;
+      }
+    }
+
+    if (!winner) {
+      // bus idle until the next source is due
+      uint64_t next = end;
+      for (Source &s : sources) {
+        if (s.next < next) next = s.next;
+      }
+      now = next * 1000;
+      continue;
+    }
+
+    uint32_t bits = frameBits(winner->frame.ext, winner->frame.len);
+    now += (uint64_t)bits * 1000000000 / o.baud;
+    winner->waiting = false;
+
+    const Frame &f = winner->frame;
+    uint64_t rx = now / 1000;
+    printf("%llu ID: %X Data: ", (unsigned long long)rx, f.id);
+    for (int c = 0; c < f.len; c++) printf("%X ", f.buf[c]);
+    printf("\n");
+
+    tot.sent++;
+    tot.bits += bits;
+    if (winner->pe3) {
+      tot.pe3Sent++;
+      uint32_t latency = (uint32_t)(rx - winner->queued);
+      if (latency > tot.worstLatency) tot.worstLatency = latency;
+    }
+  }
+
+  fprintf(stderr,
+          "%llu frames (%llu PE3) in %u s, load %.1f %%\n"
+          "PE3 dropped %llu, corrupted %llu, worst latency %u us\n"
+          "frames lost waiting for the bus %llu\n",
+          (unsigned long long)tot.sent, (unsigned long long)tot.pe3Sent,
+          o.seconds, 100.0 * tot.bits / ((double)o.baud * o.seconds),
+          (unsigned long long)tot.dropped, (unsigned long long)tot.corrupted,
+          tot.worstLatency, (unsigned long long)tot.overrun);
+  return 0;
+}
@@ -0,0 +1,61 @@
+# Static RAM budget report, run by PlatformIO after linking (extra_scripts
+# in platformio.ini). Lists the biggest .data and .bss symbols, totals them
+# against custom_ram_budget and fails the build if they don't fit, leaving
+# the rest of the 64 KB for the stack. Also flags it if anything pulled in
+# malloc, since everything is meant to be sized at compile time.
+#
+# By hand: python tools/ramReport.py firmware.elf [nm] [budget]
+
+import subprocess
+import sys
+
+TOP = 15
+
+
+def report(elf, nm, budget):
+    out = subprocess.check_output([nm, "-S", "--size-sort", "-C", elf])
+    data, bss, heap = [], [], False
+    for line in out.decode().splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        size, kind, name = int(parts[1], 16), parts[2], parts[3]
+        if kind in "bB":
+            bss.append((size, name))
+        elif kind in "dD":
+            data.append((size, name))
+        elif kind in "tT" and name in ("malloc", "_malloc_r", "_sbrk"):
+            heap = True
+
+    total = sum(s for s, _ in data) + sum(s for s, _ in bss)
+    print("RAM budget: %d bytes .data, %d bytes .bss, %d of %d" %
+          (sum(s for s, _ in data), sum(s for s, _ in bss), total, budget))
+    for size, name in sorted(data + bss, reverse=True)[:TOP]:
+        print("  %6d  %s" % (size, name))
+    if heap:
+        print("RAM budget: warning, malloc is linked in")
+
+    if total > budget:
+        print("RAM budget: over by %d bytes" % (total - budget))
+        return False
+    return True
+
+
+try:
+    Import("env")  # noqa: F821, provided by PlatformIO
+except NameError:
+    env = None
+
+if env is None:
+    ok = report(sys.argv[1],
+                sys.argv[2] if len(sys.argv) > 2 else "arm-none-eabi-nm",
+                int(sys.argv[3]) if len(sys.argv) > 3 else 49152)
+    sys.exit(0 if ok else 1)
+else:
+    def ramReport(source, target, env):
+        nm = env.subst("$CC").replace("gcc", "nm")
+        budget = int(env.GetProjectOption("custom_ram_budget", "49152"))
+        if not report(str(target[0]), nm, budget):
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", ramReport)
@@ -0,0 +1,47 @@
+#!/bin/sh
+# builds the host replay and runs every trace in golden/ against its .leds
+# file, then builds and runs the unit tests in tests/. run from the repo
+# root; --update rewrites the goldens instead, for when a display change is
+# meant to be visible
+set -e
+build="${TMPDIR:-/tmp}/teensytach-host"
+replay="${TMPDIR:-/tmp}/teensytach-replay"
+flags="-O2 -std=gnu++14 -Itools/replay/host -Iinclude"
+
+# host/hostLedDrivers.cpp stands in for src/ledDrivers.cpp. the goldens
+# cover tach, shift and the redline strobe (mixed, limiter) and, with the
+# engine off, battery, the tps bar, the mode dwell and a warning overlay
+# (throttle). the limits leave 2-4x headroom over the p99 a desktop sees
+g++ $flags $(ls src/*.cpp | grep -v ledDrivers) tools/replay/host/host*.cpp \
+  tools/replay/replay.cpp -o "$replay"
+
+status=0
+for trace in tools/replay/golden/*.trace; do
+  leds="${trace%.trace}.leds"
+  echo "$trace"
+  if [ "$1" = "--update" ]; then
+    "$replay" "$trace" --write "$leds"
+  elif ! "$replay" "$trace" --golden "$leds" --max-frame-ns 2000 \
+      --max-render-ns 20000; then
+    status=1
+  fi
+done
+[ "$1" = "--update" ] && exit $status
+
+# the tests link the firmware without main.cpp, and the dashrx receiver
+rm -rf "$build" && mkdir -p "$build"
+for src in $(ls src/*.cpp | grep -v -e ledDrivers -e main.cpp) \
+    tools/replay/host/host*.cpp tools/dashrx/dashReceiver.cpp; do
+  g++ $flags -c "$src" -o "$build/$(basename "$src" .cpp).o"
+done
+ar rcs "$build/firmware.a" "$build"/*.o
+
+for test in tools/replay/tests/*Test.cpp; do
+  name=$(basename "$test" .cpp)
+  g++ $flags -Itools/replay/tests -Itools/dashrx "$test" "$build/firmware.a" \
+    -o "$build/$name"
+  if ! "$build/$name"; then
+    status=1
+  fi
+done
+exit $status
@@ -0,0 +1,59 @@
+/*
+   Host replay shim for the parts of the Teensy core the firmware uses
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hostHooks.h"
+#include "kinetis.h"
+
+#define HEX 16
+#define DEC 10
+#define OUTPUT 1
+#define INPUT 0
+#define HIGH 1
+#define LOW 0
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint8_t digitalRead(uint8_t pin);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+class HostSerial {
+public:
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+  int availableForWrite(void) { return 64; }
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t len);
+  size_t print(const char *s);
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) {
+    return print((unsigned long)n, base);
+  }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+  size_t println(void) { return print("\r\n"); }
+  int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HostSerial Serial;
+
+#define WAIT_FOR_INTERRUPT() hostOnWait()
+
+#endif
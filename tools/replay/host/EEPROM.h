@@ -0,0 +1,35 @@
+/*
+   Host replay shim for the Teensy EEPROM library, 2 KB starting erased
+ */
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+class EEPROMClass {
+public:
+  EEPROMClass() { memset(data, 0xFF, sizeof(data)); }
+
+  uint8_t read(int addr) { return data[addr]; }
+  void write(int addr, uint8_t v) { data[addr] = v; }
+  void update(int addr, uint8_t v) { data[addr] = v; }
+  uint16_t length(void) { return sizeof(data); }
+
+  template <typename T> T &get(int addr, T &t) {
+    memcpy(&t, data + addr, sizeof(T));
+    return t;
+  }
+  template <typename T> const T &put(int addr, const T &t) {
+    memcpy(data + addr, &t, sizeof(T));
+    return t;
+  }
+
+private:
+  uint8_t data[2048];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,54 @@
+/*
+   Host replay shim for the FlexCAN library. The replay hands frames
+   straight to the attached listener, so the bus calls do nothing
+ */
+
+#ifndef FLEXCAN_H
+#define FLEXCAN_H
+
+#include <Arduino.h>
+
+typedef struct CAN_message_t {
+  uint32_t id;
+  uint8_t ext;
+  uint8_t len;
+  uint16_t timeout;
+  uint8_t buf[8];
+} CAN_message_t;
+
+typedef struct CAN_filter_t {
+  uint8_t rtr;
+  uint8_t ext;
+  uint32_t id;
+} CAN_filter_t;
+
+class CANListener {
+public:
+  virtual ~CANListener() {}
+  virtual void gotFrame(CAN_message_t &frame, int mailbox) {}
+  void attachGeneralHandler(void) {}
+};
+
+class FlexCAN {
+public:
+  void begin(uint32_t baud = 125000) {}
+  void begin(uint32_t baud, const CAN_filter_t &mask, uint8_t txAlt,
+             uint8_t rxAlt) {}
+  void end(void) {}
+  int available(void) { return 0; }
+  int read(CAN_message_t &frame) { return 0; }
+  int write(const CAN_message_t &frame); // printed with --serial
+  void setFilter(const CAN_filter_t &filter, uint8_t n) {}
+  bool attachObj(CANListener *l) {
+    listener = l;
+    return true;
+  }
+  CANListener *attached(void) const { return listener; }
+
+private:
+  CANListener *listener = 0;
+};
+
+extern FlexCAN Can0;
+
+#endif
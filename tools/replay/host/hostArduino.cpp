@@ -0,0 +1,102 @@
+/*
+   Host replay shims, the out of line parts
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <FlexCAN.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+static uint32_t clockMicros = 0;
+static uint8_t pins[64];
+
+void (*hostOnShow)(const uint8_t *rgb, int count) = 0;
+void (*hostOnWait)(void) = 0;
+bool hostSerialEcho = false;
+
+HostSerial Serial;
+FlexCAN Can0;
+EEPROMClass EEPROM;
+
+volatile uint32_t FLEXCAN0_MCR, FLEXCAN0_CTRL1, FLEXCAN0_ESR1;
+volatile uint32_t CORE_PIN3_CONFIG;
+volatile uint32_t ARM_DEMCR, ARM_DWT_CTRL;
+
+void hostSetMicros(uint32_t t) {
+  if ((int32_t)(t - clockMicros) > 0) {
+    clockMicros = t;
+  }
+}
+
+uint32_t hostMicros(void) { return clockMicros; }
+
+uint32_t hostCycles(void) {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+uint32_t millis(void) { return clockMicros / 1000; }
+uint32_t micros(void) { return clockMicros; }
+void delay(uint32_t ms) { hostSetMicros(clockMicros + ms * 1000); }
+void delayMicroseconds(uint32_t us) { hostSetMicros(clockMicros + us); }
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t value) { pins[pin & 63] = value; }
+uint8_t digitalRead(uint8_t pin) { return pins[pin & 63]; }
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+int FlexCAN::write(const CAN_message_t &frame) {
+  if (hostSerialEcho) {
+    fprintf(stderr, "tx ID: %X Data: ", (unsigned)frame.id);
+    for (int i = 0; i < frame.len; i++) fprintf(stderr, "%X ", frame.buf[i]);
+    fprintf(stderr, "\n");
+  }
+  return 1;
+}
+
+size_t HostSerial::write(uint8_t c) {
+  if (hostSerialEcho) fputc(c, stderr);
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t *buf, size_t len) {
+  if (hostSerialEcho) fwrite(buf, 1, len, stderr);
+  return len;
+}
+
+size_t HostSerial::print(const char *s) {
+  return write((const uint8_t *)s, strlen(s));
+}
+
+size_t HostSerial::print(long n, int base) {
+  char buf[24];
+  if (base == HEX) {
+    snprintf(buf, sizeof(buf), "%lX", (unsigned long)n);
+  } else {
+    snprintf(buf, sizeof(buf), "%ld", n);
+  }
+  return print(buf);
+}
+
+size_t HostSerial::print(unsigned long n, int base) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", n);
+  return print(buf);
+}
+
+int HostSerial::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  print(buf);
+  return n;
+}
@@ -0,0 +1,28 @@
+/*
+   Host side of the replay shims
+   The Arduino, FlexCAN and EEPROM headers in this directory stand in for
+   the Teensy ones, and hostLedDrivers.cpp for src/ledDrivers.cpp, so the
+   rest of the firmware builds unchanged on a PC.
+   Time only moves when the replay moves it, so a run is the same every
+   time whatever the host is doing.
+ */
+
+#ifndef HOST_HOOKS_H
+#define HOST_HOOKS_H
+
+#include <stdint.h>
+
+void hostSetMicros(uint32_t t); // never goes backwards
+uint32_t hostMicros(void);
+
+// called from strip.show() with the pixels as they'd go out, in r g b order
+extern void (*hostOnShow)(const uint8_t *rgb, int count);
+
+// called in place of wfi, should move the clock on and deliver interrupts
+extern void (*hostOnWait)(void);
+
+extern bool hostSerialEcho; // copy Serial output to stderr
+
+uint32_t hostCycles(void); // host ns, stands in for the DWT cycle counter
+
+#endif
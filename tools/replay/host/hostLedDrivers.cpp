@@ -0,0 +1,37 @@
+/*
+   Host replay stand-ins for src/ledDrivers.cpp
+   Each driver turns the frame back into r g b using its chip's colour
+   order and hands it to the replay. Brightness is left as the strip
+   applied it, so an APA102 build records undimmed colours.
+ */
+
+#include "ledStrip.h"
+
+#include "hostHooks.h"
+
+template <ColorOrder Order>
+static void showFrame(const uint8_t *bytes, int leds) {
+  uint8_t rgb[64 * 3];
+  if (leds > 64) {
+    leds = 64;
+  }
+  for (int i = 0; i < leds; i++) {
+    const uint8_t *p = bytes + i * 3;
+    rgb[i * 3] = p[ColorOffsets<Order>::r];
+    rgb[i * 3 + 1] = p[ColorOffsets<Order>::g];
+    rgb[i * 3 + 2] = p[ColorOffsets<Order>::b];
+  }
+  if (hostOnShow) hostOnShow(rgb, leds);
+}
+
+void Ws2812Driver::begin(uint8_t) {}
+void Ws2812Driver::write(uint8_t, const uint8_t *bytes, int leds, uint8_t,
+                         uint8_t *) {
+  showFrame<Ws2812Driver::order>(bytes, leds);
+}
+
+void Apa102Driver::begin(uint8_t) {}
+void Apa102Driver::write(uint8_t, const uint8_t *bytes, int leds, uint8_t,
+                         uint8_t *) {
+  showFrame<Apa102Driver::order>(bytes, leds);
+}
@@ -0,0 +1,35 @@
+/*
+   Host replay shim for the registers the firmware touches
+ */
+
+#ifndef KINETIS_H
+#define KINETIS_H
+
+#include <stdint.h>
+
+#include "hostHooks.h"
+
+extern volatile uint32_t FLEXCAN0_MCR, FLEXCAN0_CTRL1, FLEXCAN0_ESR1;
+extern volatile uint32_t ARM_DEMCR, ARM_DWT_CTRL;
+extern volatile uint32_t CORE_PIN3_CONFIG;
+
+#define ARM_DWT_CYCCNT (hostCycles())
+
+#define FLEXCAN_MCR_FRZ 0x40000000
+#define FLEXCAN_MCR_HALT 0x10000000
+#define FLEXCAN_MCR_NOT_RDY 0x08000000
+#define FLEXCAN_MCR_FRZ_ACK 0x01000000
+#define FLEXCAN_CTRL_LOM 0x00000008
+#define FLEXCAN_ESR_STF_ERR 0x00000400
+#define FLEXCAN_ESR_FRM_ERR 0x00000800
+#define FLEXCAN_ESR_CRC_ERR 0x00001000
+#define FLEXCAN_ESR_ACK_ERR 0x00002000
+#define FLEXCAN_ESR_BIT0_ERR 0x00004000
+#define FLEXCAN_ESR_BIT1_ERR 0x00008000
+#define PORT_PCR_MUX(n) ((uint32_t)((n) & 7) << 8)
+#define ARM_DEMCR_TRCENA (1 << 24)
+#define ARM_DWT_CTRL_CYCCNTENA 1
+
+#define F_CPU 96000000
+
+#endif
@@ -0,0 +1,331 @@
+/*
+   replay, runs the firmware on a PC against a recorded or generated trace
+   Builds main.cpp and the rest of src/ unchanged against the shims in
+   host/, which also replace the led drivers. Each frame of the trace goes
+   to the CAN listener at its time, and every frame pushed to the strip is
+   recorded with its virtual time.
+
+   Traces are printFrame() text, as from pe3gen, a LOG_LEVEL_TRACE serial
+   log or a capture dump. A leading timestamp is in us (--ms for capture
+   dumps); lines without one are spaced --interval us apart. Trace time
+   starts when setup() returns.
+
+   The strip output can be written out (--write) or compared against a
+   stored golden file (--golden). Every frame is compared, the first few
+   that differ are printed and the run fails if any did. Host time spent
+   handling each CAN frame and each render is reported, and --max-frame-ns
+   / --max-render-ns fail the run if the 99th percentile goes over, so a
+   slow change fails as well as a wrong one.
+
+   build: g++ -O2 -std=gnu++14 -Itools/replay/host -Iinclude \
+            $(ls src/[a-z]*.cpp | grep -v ledDrivers) \
+            tools/replay/host/host*.cpp tools/replay/replay.cpp -o replay
+   run:   ./pe3gen --seconds 20 > trace.txt
+          ./replay trace.txt --write golden.txt
+          ./replay trace.txt --golden golden.txt --max-render-ns 20000
+ */
+
+#include <Arduino.h>
+#include <FlexCAN.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "displayMode.h"
+#include "scheduler.h"
+
+// from main.cpp
+void setup(void);
+void loop(void);
+extern bool autoBaud;
+extern Scheduler scheduler;
+extern ModeMachine displayMode;
+
+struct TraceFrame {
+  uint32_t t; // us from the end of setup()
+  CAN_message_t msg;
+};
+
+static std::vector<TraceFrame> trace;
+static size_t nextFrame = 0;
+static uint32_t startMicros = 0; // when setup() returned
+static uint32_t endMicros = 0;
+
+static std::vector<uint32_t> frameNs, renderNs;
+static uint32_t shows = 0;
+static bool shown = false;
+
+struct ReplayDone {}; // thrown to leave a sleep once the trace has run out
+
+// -------------------------------------------------------------
+// output, one line per strip.show(): virtual us then rrggbb per led
+
+static FILE *writeFile = 0;
+static FILE *goldenFile = 0;
+static uint32_t mismatches = 0;
+
+static void onShow(const uint8_t *rgb, int count) {
+  shows++;
+  shown = true;
+
+  char line[16 + 64 * 7];
+  int n = snprintf(line, sizeof(line), "%u", micros());
+  for (int i = 0; i < count; i++) {
+    n += snprintf(line + n, sizeof(line) - n, " %02x%02x%02x", rgb[i * 3],
+                  rgb[i * 3 + 1], rgb[i * 3 + 2]);
+  }
+
+  if (writeFile) fprintf(writeFile, "%s\n", line);
+
+  if (goldenFile) {
+    char golden[sizeof(line) + 2];
+    if (!fgets(golden, sizeof(golden), goldenFile)) {
+      golden[0] = 0;
+    }
+    golden[strcspn(golden, "\n")] = 0;
+    if (strcmp(golden, line) != 0 && mismatches++ < 5) {
+      fprintf(stderr, "frame %u differs\n  got      %s\n  expected %s\n", shows,
+              line, golden[0] ? golden : "(end of golden)");
+    }
+  }
+}
+
+// -------------------------------------------------------------
+// time
+
+static void deliver(const TraceFrame &f) {
+  CAN_message_t msg = f.msg;
+  uint32_t start = hostCycles();
+  Can0.attached()->gotFrame(msg, 0);
+  frameNs.push_back(hostCycles() - start);
+}
+
+// moves the clock to t, handing over the frames due on the way as the CAN
+// interrupt would
+static void advanceTo(uint32_t t) {
+  while (nextFrame < trace.size() &&
+         (int32_t)(trace[nextFrame].t + startMicros - t) <= 0) {
+    hostSetMicros(trace[nextFrame].t + startMicros);
+    deliver(trace[nextFrame++]);
+  }
+  hostSetMicros(t);
+}
+
+// wfi, sleeps until the next systick
+static void onWait(void) {
+  if ((int32_t)(micros() - endMicros) >= 0) {
+    throw ReplayDone();
+  }
+  advanceTo((micros() / 1000 + 1) * 1000);
+}
+
+// the next time a task is due, or now if one already is
+static uint32_t nextRelease(void) {
+  uint32_t now = micros();
+  uint32_t next = endMicros;
+  for (int i = 0; i < scheduler.count(); i++) {
+    uint32_t r = scheduler.task(i).nextRelease;
+    if ((int32_t)(r - now) <= 0) {
+      return now;
+    }
+    if ((int32_t)(r - next) < 0) {
+      next = r;
+    }
+  }
+  return next;
+}
+
+// -------------------------------------------------------------
+// trace
+
+static bool parseTrace(const char *path, bool ms, uint32_t interval) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+
+  char line[256];
+  bool haveFirst = false;
+  long first = 0;
+  uint32_t untimed = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char *tag = strstr(line, "ID: ");
+    if (!tag) continue;
+
+    TraceFrame tf = {};
+    char *p;
+    long ts = strtol(line, &p, 10);
+    bool timed = p != line && p <= tag;
+
+    tf.msg.id = strtoul(tag + 4, &p, 16);
+    tf.msg.ext = tf.msg.id > 0x7FF;
+    p = strstr(p, "Data:");
+    if (!p) continue;
+    p += 5;
+    while (tf.msg.len < 8) {
+      char *q;
+      unsigned long b = strtoul(p, &q, 16);
+      if (q == p) break;
+      tf.msg.buf[tf.msg.len++] = b;
+      p = q;
+    }
+
+    if (timed) {
+      if (!haveFirst) {
+        first = ts;
+        haveFirst = true;
+      }
+      tf.t = (uint32_t)(ts - first) * (ms ? 1000 : 1);
+    } else {
+      tf.t = untimed;
+      untimed += interval;
+    }
+    trace.push_back(tf);
+  }
+  fclose(f);
+
+  std::stable_sort(trace.begin(), trace.end(),
+                   [](const TraceFrame &a, const TraceFrame &b) {
+                     return a.t < b.t;
+                   });
+  return true;
+}
+
+static uint32_t percentile(std::vector<uint32_t> v, int pct) {
+  if (v.empty()) return 0;
+  size_t i = (v.size() - 1) * pct / 100;
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i];
+}
+
+static double mean(const std::vector<uint32_t> &v) {
+  double sum = 0;
+  for (uint32_t x : v) sum += x;
+  return v.empty() ? 0 : sum / v.size();
+}
+
+int main(int argc, char **argv) {
+  const char *tracePath = 0;
+  bool ms = false;
+  uint32_t interval = 1000;
+  uint32_t tail = 3000000; // keep running after the last frame, us
+  uint32_t maxFrameNs = 0, maxRenderNs = 0;
+
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : 0;
+    if (!strcmp(a, "--ms")) {
+      ms = true;
+    } else if (!strcmp(a, "--serial")) {
+      hostSerialEcho = true;
+    } else if (!strcmp(a, "--write") && v) {
+      writeFile = fopen(argv[++i], "w");
+      if (!writeFile) {
+        perror(v);
+        return 2;
+      }
+    } else if (!strcmp(a, "--golden") && v) {
+      goldenFile = fopen(argv[++i], "r");
+      if (!goldenFile) {
+        perror(v);
+        return 2;
+      }
+    } else if (!strcmp(a, "--interval") && v) {
+      interval = atoi(argv[++i]);
+    } else if (!strcmp(a, "--tail") && v) {
+      tail = atoi(argv[++i]) * 1000;
+    } else if (!strcmp(a, "--max-frame-ns") && v) {
+      maxFrameNs = atoi(argv[++i]);
+    } else if (!strcmp(a, "--max-render-ns") && v) {
+      maxRenderNs = atoi(argv[++i]);
+    } else if (a[0] != '-' && !tracePath) {
+      tracePath = a;
+    } else {
+      fprintf(stderr,
+              "usage: %s <trace> [--ms] [--interval us] [--tail ms]\n"
+              "  [--write out] [--golden file] [--max-frame-ns n]\n"
+              "  [--max-render-ns n] [--serial]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (!tracePath || !parseTrace(tracePath, ms, interval)) {
+    return 2;
+  }
+
+  hostOnShow = onShow;
+  hostOnWait = onWait;
+  autoBaud = false; // there is no bus to listen to
+
+  setup();
+  if (!Can0.attached()) {
+    fprintf(stderr, "setup() attached no CAN listener\n");
+    return 2;
+  }
+  startMicros = micros();
+  endMicros = startMicros + (trace.empty() ? 0 : trace.back().t) + tail;
+
+  try {
+    while ((int32_t)(micros() - endMicros) < 0) {
+      shown = false;
+      uint32_t start = hostCycles();
+      loop();
+      uint32_t took = hostCycles() - start;
+      if (shown) renderNs.push_back(took);
+
+      advanceTo(nextRelease());
+    }
+  } catch (ReplayDone &) {
+  }
+
+  uint32_t seconds = (micros() - startMicros) / 1000000;
+  uint32_t frameP99 = percentile(frameNs, 99);
+  uint32_t renderP99 = percentile(renderNs, 99);
+  fprintf(stderr,
+          "%zu CAN frames, %u strip updates (%.1f/s) over %u s\n"
+          "frame  mean %.0f ns  p99 %u ns  max %u ns\n"
+          "render mean %.0f ns  p99 %u ns  max %u ns\n",
+          nextFrame, shows, seconds ? (double)shows / seconds : 0.0, seconds,
+          mean(frameNs), frameP99, percentile(frameNs, 100), mean(renderNs),
+          renderP99, percentile(renderNs, 100));
+
+  // every mode change, so flapping shows up next to the timing
+  fprintf(stderr, "modes");
+  for (int from = 0; from < NUM_MODES; from++) {
+    for (int to = 0; to < NUM_MODES; to++) {
+      if (displayMode.transitions(from, to)) {
+        fprintf(stderr, " %s>%s %u", modeNames[from], modeNames[to],
+                (unsigned)displayMode.transitions(from, to));
+      }
+    }
+  }
+  fprintf(stderr, ", %u held back\n", (unsigned)displayMode.held());
+
+  bool failed = false;
+  if (goldenFile) {
+    char extra[8];
+    if (fgets(extra, sizeof(extra), goldenFile)) {
+      fprintf(stderr, "golden has more frames than this run\n");
+      mismatches++;
+    }
+    if (mismatches) {
+      fprintf(stderr, "FAIL %u frames differ from the golden\n", mismatches);
+      failed = true;
+    }
+  }
+  if (maxFrameNs && frameP99 > maxFrameNs) {
+    fprintf(stderr, "FAIL frame p99 over %u ns\n", maxFrameNs);
+    failed = true;
+  }
+  if (maxRenderNs && renderP99 > maxRenderNs) {
+    fprintf(stderr, "FAIL render p99 over %u ns\n", maxRenderNs);
+    failed = true;
+  }
+
+  if (writeFile) fclose(writeFile);
+  return failed ? 1 : 0;
+}
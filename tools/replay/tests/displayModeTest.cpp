@@ -0,0 +1,187 @@
+/*
+   Display mode test
+   Each case plays a short input trace (segments of a level plus
+   deterministic rpm noise) into a fresh ModeMachine at the check task's
+   1 ms rate. It then checks the mode at the end, how many transitions
+   fired and how many a dwell held back, so the guards, the hysteresis on
+   every threshold and the dwell times in displayMode.cpp are all under
+   test.
+ */
+
+#include "displayMode.h"
+#include "hostTest.h"
+
+static const int32_t redline = 11250;
+
+struct Step {
+  uint32_t ms; // 0 ends the trace
+  bool wakeupComplete;
+  bool ecuOnline;
+  int32_t rpm;
+  int32_t noise; // +- around rpm
+  int32_t tps;
+};
+
+struct Case {
+  const char *name;
+  Step trace[6];
+  DisplayMode end;
+  uint32_t changes; // transitions fired, counting the first out of wakeup
+  uint32_t held;
+};
+
+static const Case cases[] = {
+    // guards
+    {"wakeup holds until the light show ends",
+     {{500, false, true, 0, 0, 0}, {0}}, MODE_WAKEUP, 0, 0},
+    {"no ECU after the light show",
+     {{500, true, false, 0, 0, 0}, {0}}, MODE_HEARTBEAT, 1, 0},
+    {"ECU comes back",
+     {{500, true, false, 0, 0, 0}, {500, true, true, 0, 0, 0}, {0}},
+     MODE_BATTERY, 2, 0},
+    {"ECU lost while running acts at once",
+     {{1000, true, true, 3000, 0, 0}, {1, true, false, 3000, 0, 0}, {0}},
+     MODE_HEARTBEAT, 3, 0},
+    {"engine start acts at once",
+     {{1, true, true, 0, 0, 0}, {1, true, true, 600, 0, 0}, {0}},
+     MODE_TACH, 2, 0},
+    {"stopping with the throttle open shows tps",
+     {{1000, true, true, 3000, 0, 0}, {400, true, true, 0, 0, 500}, {0}},
+     MODE_TPS, 3, 0},
+    // rpm and tps hysteresis
+    {"rpm between the stop and run thresholds",
+     {{1000, true, true, 3000, 0, 0}, {3000, true, true, 450, 40, 0}, {0}},
+     MODE_TACH, 2, 0},
+    {"tps between the hide and show thresholds",
+     {{1000, true, true, 0, 0, 175}, {0}}, MODE_BATTERY, 1, 0},
+    // dwell
+    {"stall shorter than the dwell",
+     {{100, true, true, 3000, 0, 0}, {100, true, true, 0, 0, 0},
+      {1000, true, true, 3000, 0, 0}, {0}},
+     MODE_TACH, 2, 100},
+    {"throttle blip shorter than the dwell",
+     {{100, true, true, 0, 0, 0}, {100, true, true, 0, 0, 500},
+      {1000, true, true, 0, 0, 0}, {0}},
+     MODE_BATTERY, 1, 100},
+    {"throttle held open, then shut",
+     {{500, true, true, 0, 0, 0}, {500, true, true, 0, 0, 500},
+      {1000, true, true, 0, 0, 0}, {0}},
+     MODE_BATTERY, 3, 0},
+    // redline
+    {"redline acts at once",
+     {{1000, true, true, 10000, 0, 0}, {1, true, true, 11300, 0, 0}, {0}},
+     MODE_REDLINE, 3, 0},
+    {"limiter bouncing inside the redline hysteresis",
+     {{1000, true, true, 10000, 0, 0}, {3000, true, true, 11250, 200, 0},
+      {0}},
+     MODE_REDLINE, 3, 0},
+    {"dip under the redline shorter than the dwell",
+     {{1000, true, true, 10000, 0, 0}, {100, true, true, 11300, 0, 0},
+      {100, true, true, 10500, 0, 0}, {1000, true, true, 11300, 0, 0}, {0}},
+     MODE_REDLINE, 3, 100},
+    {"off the redline after the hysteresis and dwell",
+     {{1000, true, true, 10000, 0, 0}, {100, true, true, 11300, 0, 0},
+      {1000, true, true, 10900, 0, 0}, {0}},
+     MODE_TACH, 4, 150},
+};
+
+static const int numCases = sizeof(cases) / sizeof(cases[0]);
+
+static uint32_t noiseState = 1;
+
+static int32_t noise(int32_t amplitude) {
+  if (!amplitude) {
+    return 0;
+  }
+  noiseState = noiseState * 1103515245 + 12345;
+  return (int32_t)((noiseState >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+static uint32_t totalFired(const ModeMachine &m) {
+  uint32_t n = 0;
+  for (int from = 0; from < NUM_MODES; from++) {
+    for (int to = 0; to < NUM_MODES; to++) {
+      n += m.transitions(from, to);
+    }
+  }
+  return n;
+}
+
+// the order actions run in, as exit / enter pairs
+static int actionLog[8];
+static int actions = 0;
+
+static void logExit(DisplayMode from, DisplayMode, uint32_t) {
+  if (actions < 8) actionLog[actions++] = -1 - from;
+}
+static void logEnter(DisplayMode, DisplayMode to, uint32_t) {
+  if (actions < 8) actionLog[actions++] = to;
+}
+
+int main(void) {
+  for (int c = 0; c < numCases; c++) {
+    const Case &test = cases[c];
+    ModeMachine m;
+
+    noiseState = 1;
+    uint32_t now = 1000;
+    for (const Step *step = test.trace; step->ms; step++) {
+      for (uint32_t t = 0; t < step->ms; t++, now++) {
+        ModeInputs in = {step->wakeupComplete, step->ecuOnline,
+                         step->rpm + noise(step->noise), step->tps, redline};
+        m.update(in, now);
+      }
+    }
+
+    if (m.mode() != test.end || totalFired(m) != test.changes ||
+        m.held() != test.held) {
+      fprintf(stderr,
+              "%s: ended in %s after %u changes, %u held back, expected "
+              "%s, %u, %u\n",
+              test.name, modeNames[m.mode()], (unsigned)totalFired(m),
+              (unsigned)m.held(), modeNames[test.end],
+              (unsigned)test.changes, (unsigned)test.held);
+      testFailures++;
+    }
+  }
+
+  // counters and actions, through battery, tach and back on one machine
+  ModeMachine m;
+  m.onExit(MODE_BATTERY, logExit);
+  m.onEnter(MODE_TACH, logEnter);
+  m.onExit(MODE_TACH, logExit);
+  m.onEnter(MODE_BATTERY, logEnter);
+
+  ModeInputs in = {true, true, 0, 0, redline};
+  m.update(in, 0);
+  EXPECT_EQ(m.mode(), MODE_BATTERY);
+  EXPECT_EQ(actions, 1); // wakeup has no exit action
+  EXPECT_EQ(actionLog[0], MODE_BATTERY);
+
+  in.rpm = 3000;
+  m.update(in, 10);
+  EXPECT_EQ(m.mode(), MODE_TACH);
+  EXPECT_EQ(m.timeInMode(30), 20);
+
+  in.rpm = 0;
+  m.update(in, 20); // 10 ms into tach, held back
+  m.update(in, 260);
+  EXPECT_EQ(m.mode(), MODE_BATTERY);
+  EXPECT_EQ(m.held(), 1);
+  EXPECT_EQ(actions, 5);
+  EXPECT_EQ(actionLog[1], -1 - MODE_BATTERY);
+  EXPECT_EQ(actionLog[2], MODE_TACH);
+  EXPECT_EQ(actionLog[3], -1 - MODE_TACH);
+  EXPECT_EQ(actionLog[4], MODE_BATTERY);
+  EXPECT_EQ(m.transitions(MODE_WAKEUP, MODE_BATTERY), 1);
+  EXPECT_EQ(m.transitions(MODE_BATTERY, MODE_TACH), 1);
+  EXPECT_EQ(m.transitions(MODE_TACH, MODE_BATTERY), 1);
+
+  m.resetCounters();
+  EXPECT_EQ(totalFired(m), 0);
+  EXPECT_EQ(m.held(), 0);
+  EXPECT_EQ(m.mode(), MODE_BATTERY);
+
+  fprintf(stderr, "%d mode traces\n", numCases);
+  return testResult("displayMode");
+}
@@ -0,0 +1,187 @@
+/*
+   ECU profile decode test
+   Each profile gets frames built by hand from its protocol document with
+   known values in them, through its own subscribe() and a dispatch table
+   as on the Teensy, and every channel it maps is checked in firmware
+   units. Frames it doesn't decode must leave the signals alone.
+ */
+
+#include "canDispatch.h"
+#include "ecuProfiles.h"
+#include "hostTest.h"
+
+#include <string.h>
+
+int Pe3Profile::oilPressureInput = 2; // main.cpp's is not linked in
+
+struct Frame {
+  uint32_t id;
+  uint8_t buf[8];
+};
+
+struct Decoded {
+  int32_t value[NUM_SIGNALS];
+  bool seen[NUM_SIGNALS];
+  void set(SignalId id, int32_t v) {
+    value[id] = v;
+    seen[id] = true;
+  }
+};
+
+static Decoded decoded;
+
+template <typename Profile> static void onFrame(const Frame &frame) {
+  Profile::decode(frame.id, frame.buf, decoded);
+}
+
+// runs frames through a table the profile subscribed itself to
+template <typename Profile>
+static void play(const Frame *frames, int count) {
+  memset(&decoded, 0, sizeof(decoded));
+  CanDispatch<Frame> dispatch;
+  Profile::subscribe(dispatch, onFrame<Profile>);
+  for (int i = 0; i < count; i++) {
+    EXPECT(dispatch.dispatch(frames[i]));
+  }
+}
+
+static void expectSignal(SignalId id, int32_t value) {
+  if (!decoded.seen[id]) {
+    fprintf(stderr, "signal %d not decoded\n", id);
+    testFailures++;
+  } else {
+    EXPECT_EQ(decoded.value[id], value);
+  }
+}
+
+static void expectUnset(SignalId id) { EXPECT(!decoded.seen[id]); }
+
+static void pe3(void) {
+  const Frame frames[] = {
+      // rpm 6500, tps 45.3 %
+      {Pe3Profile::PE1, {0x64, 0x19, 0xC5, 0x01, 0, 0, 0, 0}},
+      // lambda 0.98
+      {Pe3Profile::PE2, {0, 0, 0, 0, 98, 0, 0, 0}},
+      // analog inputs 1-4, oil on input 3 at 2.345 V
+      {Pe3Profile::PE3, {1, 0, 2, 0, 0x29, 0x09, 4, 0}},
+      // 13.80 V, air 86.0 F, coolant 203.0 F, Fahrenheit
+      {Pe3Profile::PE6, {0x64, 0x05, 0x5C, 0x03, 0xEE, 0x07, 0, 0}},
+  };
+  play<Pe3Profile>(frames, 4);
+  expectSignal(SIG_RPM, 6500);
+  expectSignal(SIG_TPS, 453);
+  expectSignal(SIG_LAMBDA, 98);
+  expectSignal(SIG_OIL_PRESSURE, 2345);
+  expectSignal(SIG_VOLTS, 1380);
+  expectSignal(SIG_AIR_TEMP, 300);
+  expectSignal(SIG_COOLANT_TEMP, 950);
+
+  // the same temps from an ECU set to Celsius
+  const Frame celsius = {Pe3Profile::PE6,
+                         {0x64, 0x05, 0x2C, 0x01, 0xB6, 0x03, 1, 0}};
+  play<Pe3Profile>(&celsius, 1);
+  expectSignal(SIG_AIR_TEMP, 300);
+  expectSignal(SIG_COOLANT_TEMP, 950);
+  expectUnset(SIG_RPM);
+}
+
+// priority 3 (6 for EEC1/2), the PGN, then source address 0x00 or 0x17
+static uint32_t j1939Id(uint8_t priority, uint32_t pgn, uint8_t source) {
+  return ((uint32_t)priority << 26) | (pgn << 8) | source;
+}
+
+static void j1939(void) {
+  const Frame frames[] = {
+      // EEC1 SPN 190, 0.125 rpm/bit in bytes 4-5: 3000 rpm
+      {j1939Id(3, J1939Profile::EEC1, 0x00), {0, 0, 0, 0xC0, 0x5D, 0, 0, 0}},
+      // EEC2 SPN 91, 0.4 %/bit in byte 2: 50 %
+      {j1939Id(3, J1939Profile::EEC2, 0x00), {0, 125, 0, 0, 0, 0, 0, 0}},
+      // ET1 SPN 110, byte 1, -40 C offset: 90 C
+      {j1939Id(6, J1939Profile::ET1, 0x00), {130, 0, 0, 0, 0, 0, 0, 0}},
+      // IC1 SPN 105, byte 3: 35 C
+      {j1939Id(6, J1939Profile::IC1, 0x17), {0, 0, 75, 0, 0, 0, 0, 0}},
+      // VEP1 SPN 168 at bytes 5-6, 0.05 V/bit: 13.85 V. SPN 158 keyswitch
+      // potential in bytes 7-8 reads 12.00 V and must not be the one used
+      {j1939Id(6, J1939Profile::VEP1, 0x00),
+       {0, 0, 0, 0, 0x15, 0x01, 0xF0, 0x00}},
+  };
+  play<J1939Profile>(frames, 5);
+  expectSignal(SIG_RPM, 3000);
+  expectSignal(SIG_TPS, 500);
+  expectSignal(SIG_COOLANT_TEMP, 900);
+  expectSignal(SIG_AIR_TEMP, 350);
+  expectSignal(SIG_VOLTS, 1385);
+
+  // PDU1 PGNs carry a destination in the PS byte, matched on PF alone
+  EXPECT_EQ(j1939Pgn(0x18EAFF00), 0xEA00);
+  EXPECT_EQ(j1939Pgn(j1939Id(3, J1939Profile::EEC1, 0x3C)),
+            J1939Profile::EEC1);
+}
+
+static void haltech(void) {
+  const Frame frames[] = {
+      // rpm 7200, MAP 101.3 kPa, tps 62.5 %
+      {HaltechProfile::ENGINE, {0x1C, 0x20, 0x03, 0xF5, 0x02, 0x71, 0, 0}},
+      // wideband 1 at 0.875 lambda
+      {HaltechProfile::LAMBDA, {0x03, 0x6B, 0, 0, 0, 0, 0, 0}},
+      // battery 14.1 V
+      {HaltechProfile::POWER, {0x00, 0x8D, 0, 0, 0, 0, 0, 0}},
+      // coolant 363.2 K (90.0 C), air 298.2 K (25.0 C)
+      {HaltechProfile::TEMPS, {0x0E, 0x30, 0x0B, 0xA6, 0, 0, 0, 0}},
+  };
+  play<HaltechProfile>(frames, 4);
+  expectSignal(SIG_RPM, 7200);
+  expectSignal(SIG_TPS, 625);
+  expectSignal(SIG_LAMBDA, 87);
+  expectSignal(SIG_VOLTS, 1410);
+  expectSignal(SIG_COOLANT_TEMP, 900);
+  expectSignal(SIG_AIR_TEMP, 250);
+}
+
+static void aem(void) {
+  // rpm 16384 counts is 6400 rpm, tps 32768 counts is 50.0 %, air -5 C,
+  // coolant 88 C
+  const Frame engine = {AemProfile::ENGINE,
+                        {0x40, 0x00, 0, 0, 0x80, 0x00, 0xFB, 88}};
+  play<AemProfile>(&engine, 1);
+  expectSignal(SIG_RPM, 6400);
+  expectSignal(SIG_TPS, 500);
+  expectSignal(SIG_AIR_TEMP, -50);
+  expectSignal(SIG_COOLANT_TEMP, 880);
+  expectUnset(SIG_VOLTS);
+}
+
+static void motec(void) {
+  const Frame message[] = {
+      // header, 84 bytes, rpm 5500, tps 30.0 %
+      {MotecProfile::DASH, {0x82, 0x81, 0x80, 0x54, 0x15, 0x7C, 0x01, 0x2C}},
+      // MAP 98.0 kPa, air 28.5 C, engine temp -2.0 C, lambda 1.020
+      {MotecProfile::DASH, {0x03, 0xD4, 0x01, 0x1D, 0xFF, 0xEC, 0x03, 0xFC}},
+      // further words aren't mapped
+      {MotecProfile::DASH, {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0}},
+  };
+  play<MotecProfile>(message, 3);
+  expectSignal(SIG_RPM, 5500);
+  expectSignal(SIG_TPS, 300);
+  expectSignal(SIG_AIR_TEMP, 285);
+  expectSignal(SIG_COOLANT_TEMP, -20);
+  expectSignal(SIG_LAMBDA, 102);
+
+  // joining part way through a message decodes nothing until the header
+  memset(&decoded, 0, sizeof(decoded));
+  MotecProfile::frameIndex() = 0xFF;
+  MotecProfile::decode(MotecProfile::DASH, message[1].buf, decoded);
+  MotecProfile::decode(MotecProfile::DASH, message[2].buf, decoded);
+  for (int i = 0; i < NUM_SIGNALS; i++) {
+    expectUnset((SignalId)i);
+  }
+}
+
+int main(void) {
+  pe3();
+  j1939();
+  haltech();
+  aem();
+  motec();
+  return testResult("ecuProfiles");
+}
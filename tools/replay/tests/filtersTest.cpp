@@ -0,0 +1,126 @@
+/*
+   Filter test
+   Each case runs a 0 to 1000 step, then a separate one sample 1000 spike
+   on a 0 baseline, through filterSample() at the channel's update period.
+   It checks when the step first reads 900 (the rise time), when it stays
+   within 1 of 1000 for good (settling) and how much of the spike gets
+   through. The configs are the ones signals.cpp uses plus the rate limit,
+   so a change to the fixed point maths or to a channel's tuning shows up
+   here. The stale restart is checked through the signal store.
+ */
+
+#include "filters.h"
+#include "hostTest.h"
+#include "signals.h"
+
+#include <stdlib.h>
+
+struct Case {
+  const char *name;
+  FilterConfig config;
+  uint32_t periodMs;
+  uint32_t riseMs;   // first sample at or over 900
+  uint32_t settleMs; // from here on within 1 of 1000
+  int32_t spike;     // largest output from the spike
+};
+
+static const Case cases[] = {
+    // the median delays by (n - 1) / 2 samples and drops the spike
+    {"off", FILTER_OFF, 20, 0, 0, 1000},
+    {"median 3, rpm and tps", {3, 256, 0}, 20, 20, 20, 0},
+    {"median 5", {5, 256, 0}, 100, 200, 200, 0},
+    // the IIR reaches 900 after the first n with (1 - alpha/256)^n <= 0.1
+    {"alpha 64", {1, 64, 0}, 20, 140, 440, 250},
+    {"median 5, alpha 64, volts", {5, 64, 0}, 100, 900, 2400, 0},
+    {"median 3, alpha 32, temps", {3, 32, 0}, 100, 1800, 4900, 0},
+    {"median 3, alpha 128, lambda", {3, 128, 0}, 100, 400, 1000, 0},
+    // 20 per 20 ms sample
+    {"rate 1000/s", {1, 256, 1000}, 20, 880, 980, 20},
+};
+
+static const int numCases = sizeof(cases) / sizeof(cases[0]);
+
+static const uint32_t runMs = 10000;
+
+// feeds input from t = 0 and keeps the output of every sample
+static void run(const Case &test, int32_t (*input)(uint32_t t),
+                int32_t *out, int samples) {
+  FilterState state = {};
+  for (int i = 0; i < samples; i++) {
+    uint32_t t = i * test.periodMs;
+    out[i] = filterSample(test.config, state, input(t), 1000 + t);
+  }
+}
+
+// the step and the spike land on the fifth sample, once the median is full
+static uint32_t edge;
+static int32_t step(uint32_t t) { return t >= edge ? 1000 : 0; }
+static int32_t spike(uint32_t t) { return t == edge ? 1000 : 0; }
+
+int main(void) {
+  for (int c = 0; c < numCases; c++) {
+    const Case &test = cases[c];
+    int samples = runMs / test.periodMs;
+    int32_t *out = new int32_t[samples];
+    edge = 4 * test.periodMs;
+
+    run(test, step, out, samples);
+    int rise = -1, settle = -1;
+    for (int i = 0; i < samples; i++) {
+      if (rise < 0 && out[i] >= 900) {
+        rise = i;
+      }
+      if (abs(out[i] - 1000) > 1) {
+        settle = -1;
+      } else if (settle < 0) {
+        settle = i;
+      }
+    }
+    uint32_t riseMs = rise < 0 ? runMs : rise * test.periodMs - edge;
+    uint32_t settleMs = settle < 0 ? runMs : settle * test.periodMs - edge;
+
+    run(test, spike, out, samples);
+    int32_t through = 0;
+    for (int i = 0; i < samples; i++) {
+      if (out[i] > through) {
+        through = out[i];
+      }
+    }
+
+    if (riseMs != test.riseMs || settleMs != test.settleMs ||
+        through != test.spike) {
+      fprintf(stderr,
+              "%s: rise %u ms, settle %u ms, spike %d, expected %u, %u, "
+              "%d\n",
+              test.name, (unsigned)riseMs, (unsigned)settleMs, (int)through,
+              (unsigned)test.riseMs, (unsigned)test.settleMs,
+              (int)test.spike);
+      testFailures++;
+    }
+    delete[] out;
+  }
+
+  // volts after a gap: with the restart the first sample back reads as is,
+  // without it the median and IIR still hold the 12.00 V from before
+  for (int i = 0; i < 10; i++) {
+    updateSignal(SIG_VOLTS, 1200, i * 100);
+  }
+  checkStale(1000);
+  EXPECT(signalFresh(SIG_VOLTS));
+  checkStale(2000);
+  EXPECT(!signalFresh(SIG_VOLTS));
+  EXPECT_EQ(signals[SIG_VOLTS].staleEvents, 1);
+  updateSignal(SIG_VOLTS, 1400, 2100);
+  EXPECT_EQ(signals[SIG_VOLTS].value, 1400);
+
+  // a channel that stays fresh keeps filtering across the same change
+  for (int i = 0; i < 10; i++) {
+    updateSignal(SIG_AIR_TEMP, 300, i * 100);
+  }
+  checkStale(1000);
+  updateSignal(SIG_AIR_TEMP, 400, 1000);
+  EXPECT_EQ(signals[SIG_AIR_TEMP].value, 300);
+
+  fprintf(stderr, "%d filter responses\n", numCases);
+  return testResult("filters");
+}
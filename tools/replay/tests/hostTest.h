@@ -0,0 +1,40 @@
+/*
+   Host unit tests
+   Each *Test.cpp in this directory is its own program, linked against the
+   firmware modules (everything in src/ but main.cpp) and the shims in
+   ../host. check.sh builds and runs them after the golden traces.
+   EXPECT prints the failing line and carries on, testResult() turns the
+   count into the exit status.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define EXPECT(cond)                                                           \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #cond);      \
+      testFailures++;                                                          \
+    }                                                                          \
+  } while (0)
+
+#define EXPECT_EQ(a, b)                                                        \
+  do {                                                                         \
+    long long expectA = (long long)(a), expectB = (long long)(b);              \
+    if (expectA != expectB) {                                                  \
+      fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__,          \
+              __LINE__, #a, expectA, expectB);                                 \
+      testFailures++;                                                          \
+    }                                                                          \
+  } while (0)
+
+static inline int testResult(const char *name) {
+  fprintf(stderr, "%s: %s\n", name, testFailures ? "FAIL" : "ok");
+  return testFailures ? 1 : 0;
+}
+
+#endif
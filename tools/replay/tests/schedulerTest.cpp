@@ -0,0 +1,107 @@
+/*
+   Scheduler timing test
+   Runs the scheduler against a fake clock. Each task moves the clock on by
+   its own cost, so release times, jitter, overruns and skipped periods
+   are exact and can be checked against what the task set should give.
+ */
+
+#include "hostTest.h"
+#include "scheduler.h"
+
+static uint32_t fakeNow;
+static uint32_t fakeClock(void) { return fakeNow; }
+
+static uint32_t fastCost, slowCost, hogCost;
+static char order[8];
+static int orderLen;
+
+static void note(char c) {
+  if (orderLen < 7) {
+    order[orderLen++] = c;
+    order[orderLen] = 0;
+  }
+}
+
+static void fastRun(uint32_t) { note('f'); fakeNow += fastCost; }
+static void slowRun(uint32_t) { note('s'); fakeNow += slowCost; }
+static void hogRun(uint32_t) { note('h'); fakeNow += hogCost; }
+
+// idles the way loop() does between releases
+static void runUntil(Scheduler &scheduler, uint32_t end) {
+  while ((int32_t)(fakeNow - end) < 0) {
+    if (!scheduler.runOnce()) {
+      fakeNow += 10;
+    }
+  }
+}
+
+static void periodsAndJitter(uint32_t start) {
+  fakeNow = start;
+  fastCost = 100;
+  slowCost = 800; // short enough for the fast task to never miss a period
+  orderLen = 0;
+  Task fast = TASK("fast", fastRun, 1000, 500, 3);
+  Task slow = TASK("slow", slowRun, 10300, 0, 1); // drifts across fast
+  Scheduler scheduler(fakeClock);
+  scheduler.add(slow);
+  scheduler.add(fast);
+
+  runUntil(scheduler, start + 1000000);
+
+  EXPECT_EQ(order[0], 'f'); // both due at once, priority first
+  EXPECT_EQ(order[1], 's');
+  EXPECT_EQ(fast.runs, 1000);
+  EXPECT_EQ(slow.runs, 98);
+  EXPECT_EQ(fast.skipped + slow.skipped, 0);
+  EXPECT_EQ(slow.overruns, 0);
+  // the fast task can only be late when released during a slow run, and
+  // only then finish past its 500 us deadline
+  EXPECT(fast.maxJitter <= slowCost);
+  EXPECT(fast.maxJitter > fastCost);
+  EXPECT(fast.overruns > 0);
+  EXPECT(fast.overruns <= slow.runs);
+  EXPECT_EQ(fast.maxRun, fastCost);
+  EXPECT_EQ(slow.maxRun, slowCost);
+}
+
+static void skippedPeriods(void) {
+  fakeNow = 0;
+  hogCost = 3500; // three and a half periods
+  Task hog = TASK("hog", hogRun, 1000, 0, 1);
+  Scheduler scheduler(fakeClock);
+  scheduler.add(hog);
+
+  // no burst to catch up, the backlog is dropped and the next release is
+  // a period after each run ends
+  runUntil(scheduler, 10 * (3500 + 1000));
+
+  EXPECT_EQ(hog.runs, 10);
+  EXPECT_EQ(hog.overruns, 10);
+  EXPECT_EQ(hog.skipped, 30);
+}
+
+static void resyncAfterSleep(void) {
+  fakeNow = 0;
+  fastCost = 100;
+  Task fast = TASK("fast", fastRun, 1000, 0, 1);
+  Scheduler scheduler(fakeClock);
+  scheduler.add(fast);
+
+  runUntil(scheduler, 5000);
+  uint32_t before = fast.runs;
+  fakeNow += 60000000; // a minute asleep
+  scheduler.resync();
+  runUntil(scheduler, fakeNow + 5000);
+
+  EXPECT_EQ(fast.skipped, 0);
+  EXPECT_EQ(fast.overruns, 0);
+  EXPECT_EQ(fast.runs - before, 5);
+}
+
+int main(void) {
+  periodsAndJitter(0);
+  periodsAndJitter(0xFFFFFFFF - 500000); // micros() wraps half way through
+  skippedPeriods();
+  resyncAfterSleep();
+  return testResult("scheduler");
+}
@@ -0,0 +1,137 @@
+/*
+   Binary stream round trip
+   Packets come from the firmware's StreamWriter and sampleSignals(), go
+   through a pseudo terminal in uneven chunks with text log lines between
+   them, and are read back by tools/dashrx's DashReceiver. Every sample
+   must come back as it went in. One packet is dropped and one corrupted
+   on the way, and both must be counted. The device clock wraps half way
+   through at a constant link delay, which must not read as latency.
+ */
+
+#include "dashReceiver.h"
+#include "hostTest.h"
+#include "signals.h"
+#include "streamWriter.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <vector>
+
+static const int numPackets = 120;
+static const int dropPacket = 40;
+static const int corruptPacket = 80;
+static const uint32_t period = 1000;
+static const uint32_t linkDelay = 500;
+
+static int slaveFd = -1;
+static DashReceiver *receiver = 0;
+
+// everything written so far comes back out of the slave side
+static void drain(int master, const uint8_t *data, size_t len,
+                  uint64_t hostMicros) {
+  size_t sent = 0;
+  while (sent < len) {
+    size_t chunk = 1 + rand() % 23;
+    if (chunk > len - sent) {
+      chunk = len - sent;
+    }
+    EXPECT_EQ(write(master, data + sent, chunk), (long)chunk);
+    sent += chunk;
+
+    size_t got = 0;
+    uint8_t buf[64];
+    while (got < chunk) {
+      ssize_t n = read(slaveFd, buf, sizeof(buf));
+      if (n <= 0) {
+        break;
+      }
+      receiver->feed(buf, n, hostMicros);
+      got += n;
+    }
+    EXPECT_EQ(got, chunk);
+  }
+}
+
+int main(void) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) || unlockpt(master)) {
+    perror("pty");
+    return 1;
+  }
+  slaveFd = open(ptsname(master), O_RDWR | O_NOCTTY);
+  termios tio;
+  tcgetattr(slaveFd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(slaveFd, TCSANOW, &tio);
+
+  std::vector<StreamSample> received;
+  std::vector<uint64_t> arrived;
+  DashReceiver rx([&](const DashSample &s) {
+    received.push_back(s.values);
+    arrived.push_back(s.deviceMicros);
+  });
+  receiver = &rx;
+
+  srand(1);
+  std::vector<StreamSample> expected;
+  std::vector<uint64_t> expectedMicros;
+  StreamWriter writer;
+  uint64_t deviceTime = 0x100000000ull - numPackets * 3 * period / 2;
+  const char *log = "ECU Online\r\n";
+
+  for (int p = 0; p < numPackets; p++) {
+    for (int i = 0; i < samplesPerPacket; i++, deviceTime += period) {
+      int n = p * samplesPerPacket + i;
+      uint32_t now = (uint32_t)deviceTime;
+      updateSignal(SIG_RPM, 1000 + n * 37, now / 1000);
+      updateSignal(SIG_COOLANT_TEMP, -200 + n, now / 1000);
+      StreamSample s;
+      sampleSignals(s, n & 0x0F);
+      bool done = writer.add(s, now, period);
+      EXPECT_EQ(done, i == samplesPerPacket - 1);
+
+      if (p != dropPacket && p != corruptPacket) {
+        expected.push_back(s);
+        expectedMicros.push_back(now);
+      }
+    }
+
+    StreamPacket packet = writer.packet();
+    if (p == dropPacket) {
+      continue;
+    }
+    if (p == corruptPacket) {
+      packet.samples[1].rpm ^= 0x0100;
+    }
+    uint64_t hostMicros = deviceTime - period + linkDelay;
+    drain(master, (const uint8_t *)&packet, sizeof(packet), hostMicros);
+    if (p % 7 == 0) {
+      drain(master, (const uint8_t *)log, strlen(log), hostMicros);
+    }
+  }
+
+  EXPECT_EQ(received.size(), expected.size());
+  for (size_t i = 0; i < received.size() && i < expected.size(); i++) {
+    if (memcmp(&received[i], &expected[i], sizeof(StreamSample)) ||
+        arrived[i] != expectedMicros[i]) {
+      fprintf(stderr, "sample %zu differs\n", i);
+      testFailures++;
+      break;
+    }
+  }
+
+  const DashStats &stats = rx.stats();
+  EXPECT_EQ(stats.packets, numPackets - 2);
+  EXPECT_EQ(stats.lostPackets, 2);
+  EXPECT(stats.crcErrors > 0);
+  EXPECT_EQ(stats.latencyMaxUs, 0); // the same delay throughout the wrap
+  EXPECT_EQ(sizeof(StreamPacket), 62);
+
+  fprintf(stderr, "%llu packets, %llu bytes through the pty\n",
+          (unsigned long long)stats.packets, (unsigned long long)stats.bytes);
+  return testResult("stream");
+}
@@ -0,0 +1,145 @@
+/*
+   Tach bar position test
+   The whole-pixel bar (smooth = false) has to light exactly the leds the
+   old float code did: leds 0 to ceil(rpm / rpmPerLED) inclusive, clipped
+   to the strip. The smooth bar must keep the same full leds and fade its
+   leading led up steadily between them.
+
+   The throttle and battery bars are held to the baseline the same way,
+   the throttle one against ceil() of Teensyduino's double map(). A short
+   benchmark of the old double throttle path against the integer one is
+   printed, on the host. The M4F has no double FPU, so on the Teensy the
+   gap is wider: every double op there is a library call.
+ */
+
+#include "calibration.h"
+#include "hostTest.h"
+#include "tachBar.h"
+
+#include <Arduino.h>
+
+#include <math.h>
+
+// the baseline setLights(), counting instead of drawing
+static int oldLit(int rpm, int wakeUp, int redline, int numLEDs) {
+  float rpmPerLED = ((redline - wakeUp) / numLEDs);
+  int ledsToLight = ceil(rpm / rpmPerLED);
+  int lit = 0;
+  for (int i = 0; i <= ledsToLight; i++) {
+    if (i < numLEDs) {
+      lit++;
+    }
+  }
+  return lit;
+}
+
+// Teensyduino's map() for a double input does the math in double
+static double mapDouble(double x, int inMin, int inMax, int outMin,
+                        int outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// the baseline TPS branch of gotFrame() and displayTPS(), counting
+static int oldTpsLit(uint8_t low, uint8_t high, int numLEDs) {
+  double lowByte = low;
+  double highByte = high;
+  double tps = ((highByte * 256) + lowByte) / 10;
+  int ledsToLight = ceil(mapDouble(tps, 0, 100, 0, numLEDs));
+  return ledsToLight < 0 ? 0 : ledsToLight > numLEDs ? numLEDs : ledsToLight;
+}
+
+static int newLit(const TachBar &bar) {
+  return bar.fullLeds + (bar.leadLevel ? 1 : 0);
+}
+
+int main(void) {
+  static const int strips[] = {8, 16, 24, 60};
+  static const int ranges[][2] = {{1500, 11250}, {1000, 7000}, {500, 9000}};
+
+  long checked = 0;
+  for (int s = 0; s < 4; s++) {
+    for (int r = 0; r < 3; r++) {
+      int numLEDs = strips[s];
+      int wakeUp = ranges[r][0], redline = ranges[r][1];
+      int rpmPerLED = (redline - wakeUp) / numLEDs;
+
+      int lastFull = 0, lastLevel = 0;
+      for (int rpm = 0; rpm <= 20000; rpm++) {
+        TachBar whole = tachBarPosition(rpm, rpmPerLED, numLEDs, false);
+        TachBar smooth = tachBarPosition(rpm, rpmPerLED, numLEDs, true);
+        int expected = oldLit(rpm, wakeUp, redline, numLEDs);
+        if (newLit(whole) != expected) {
+          fprintf(stderr, "%d leds, %d rpm/led, %d rpm: lit %d, old %d\n",
+                  numLEDs, rpmPerLED, rpm, newLit(whole), expected);
+          testFailures++;
+        }
+        EXPECT(whole.leadLevel == 0 || whole.leadLevel == 255);
+
+        EXPECT_EQ(smooth.fullLeds, whole.fullLeds);
+        EXPECT(smooth.leadLevel <= whole.leadLevel);
+        if (smooth.fullLeds == lastFull) {
+          EXPECT(smooth.leadLevel >= lastLevel); // never dims on the way up
+        }
+        lastFull = smooth.fullLeds;
+        lastLevel = smooth.leadLevel;
+        checked++;
+      }
+    }
+  }
+
+  // nothing lit past the strip, and led 0 always on
+  EXPECT_EQ(tachBarPosition(100000, 600, 16, true).fullLeds, 16);
+  EXPECT_EQ(tachBarPosition(100000, 600, 16, true).leadLevel, 0);
+  EXPECT_EQ(tachBarPosition(0, 600, 16, true).fullLeds, 1);
+  EXPECT_EQ(tachBarPosition(-50, 600, 16, true).fullLeds, 1);
+  EXPECT_EQ(tachBarPosition(1000, 0, 16, true).fullLeds, 1);
+
+  // every raw PE3 tps value
+  for (int s = 0; s < 4; s++) {
+    int strip = strips[s];
+    for (int raw = 0; raw <= 0xFFFF; raw++) {
+      int expected = oldTpsLit(raw & 0xFF, raw >> 8, strip);
+      if (tpsBarLeds(raw, strip) != expected) {
+        fprintf(stderr, "%d leds, tps %d: lit %d, old %d\n", strip, raw,
+                tpsBarLeds(raw, strip), expected);
+        testFailures++;
+      }
+    }
+  }
+  EXPECT_EQ(tpsBarLeds(553, 16), 9); // 55.3 % lit 9 before, not 8
+  EXPECT_EQ(tpsBarLeds(625, 16), 10);
+  EXPECT_EQ(tpsBarLeds(-5, 16), 0);
+
+  // battery bar from the tables against the old integer map(v, 6, 15, ...)
+  Calibration cal = {1500, 9000, 11250, 255, 6, 15, 10, 12, 13};
+  static DisplayTables tables;
+  buildTables(cal, tables);
+  for (int v = 0; v <= DisplayTables::maxVolts; v++) {
+    long old = map(v, 6, 15, 0, numLeds);
+    EXPECT_EQ(tables.batteryLeds[v], old < 0 ? 0 : old > numLeds ? numLeds
+                                                                  : old);
+  }
+
+  // host benchmark, old double path against the integer one
+  const int rounds = 2000;
+  volatile int sink = 0;
+  uint32_t start = hostCycles();
+  for (int n = 0; n < rounds; n++) {
+    for (int raw = 0; raw <= 1000; raw++) {
+      sink += oldTpsLit(raw & 0xFF, raw >> 8, numLeds);
+    }
+  }
+  uint32_t oldNs = hostCycles() - start;
+  start = hostCycles();
+  for (int n = 0; n < rounds; n++) {
+    for (volatile int raw = 0; raw <= 1000; raw++) {
+      sink += tpsBarLeds(raw, numLeds);
+    }
+  }
+  uint32_t newNs = hostCycles() - start;
+  fprintf(stderr, "tps leds: double %.2f ns, integer %.2f ns per call\n",
+          (double)oldNs / (rounds * 1001), (double)newNs / (rounds * 1001));
+
+  fprintf(stderr, "%ld positions against the old bar\n", checked);
+  return testResult("tachBar");
+}
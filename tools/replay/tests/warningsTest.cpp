@@ -0,0 +1,136 @@
+/*
+   Warning engine test
+   Each case plays a short signal trace (segments of a level plus
+   deterministic noise, at the channel's own update period) into the
+   warning engine at the render rate. It then checks how many times the
+   warning was raised and whether it is still up at the end. The filters
+   are bypassed so the thresholds and times in warnings.cpp are what's
+   under test.
+ */
+
+#include "hostTest.h"
+#include "warnings.h"
+
+#include <string.h>
+
+struct Segment {
+  uint32_t ms;   // 0 ends the trace
+  int32_t level;
+  int32_t noise; // +- around level
+  bool updates;  // false leaves the channel silent, so it goes stale
+};
+
+struct Case {
+  const char *name;
+  WarningId warning;
+  bool engRunning;
+  Segment trace[6];
+  uint16_t raised;
+  bool activeAtEnd;
+};
+
+static const Case cases[] = {
+    // coolant raises at 105.0 C after 1 s and clears below 100.0 C
+    {"coolant noisy between clear and raise",
+     WARN_COOLANT_HOT, false,
+     {{3000, 1025, 20, true}, {0}}, 0, false},
+    {"coolant hot, noise on the raise threshold",
+     WARN_COOLANT_HOT, false,
+     {{3000, 1080, 0, true}, {5000, 1040, 35, true}, {0}}, 1, true},
+    {"coolant spikes shorter than minMs",
+     WARN_COOLANT_HOT, false,
+     {{600, 1100, 0, true}, {200, 1000, 0, true}, {600, 1100, 0, true},
+      {200, 1000, 0, true}, {0}}, 0, false},
+    {"coolant raises and clears",
+     WARN_COOLANT_HOT, false,
+     {{2000, 1100, 0, true}, {1000, 1010, 0, true}, {1000, 990, 0, true},
+      {0}}, 1, false},
+    {"coolant clears when the channel goes stale",
+     WARN_COOLANT_HOT, false,
+     {{2000, 1100, 0, true}, {1000, 1100, 0, false}, {0}}, 1, false},
+    // oil is a low-side warning, running only, raise 500 clear 700
+    {"oil low with the engine off",
+     WARN_OIL_PRESSURE, false,
+     {{3000, 300, 0, true}, {0}}, 0, false},
+    {"oil low running, recovers through the band",
+     WARN_OIL_PRESSURE, true,
+     {{1000, 300, 0, true}, {1000, 600, 90, true}, {1000, 800, 0, true},
+      {0}}, 1, false},
+    {"oil flickering on the raise threshold",
+     WARN_OIL_PRESSURE, true,
+     {{4000, 500, 60, true}, {0}}, 0, false},
+    {"volts dipping twice",
+     WARN_VOLTS_LOW, true,
+     {{2500, 1100, 0, true}, {1000, 1300, 0, true}, {2500, 1100, 0, true},
+      {0}}, 2, true},
+};
+
+static const int numCases = sizeof(cases) / sizeof(cases[0]);
+
+static uint32_t noiseState = 1;
+
+static int32_t noise(int32_t amplitude) {
+  if (!amplitude) {
+    return 0;
+  }
+  noiseState = noiseState * 1103515245 + 12345;
+  return (int32_t)((noiseState >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+// writes the channel as the CAN callback would, minus the filter
+static void feed(SignalId id, int32_t value, uint32_t now) {
+  signals[id].value = value;
+  signals[id].lastUpdate = now;
+  signals[id].valid = true;
+}
+
+static void reset(void) {
+  memset(warningStates, 0, sizeof(warningStates));
+  for (int i = 0; i < NUM_SIGNALS; i++) {
+    signals[i].valid = false;
+    signals[i].stale = false;
+  }
+  noiseState = 1;
+}
+
+int main(void) {
+  for (int c = 0; c < numCases; c++) {
+    const Case &test = cases[c];
+    const WarningRule &rule = warningRules[test.warning];
+    const WarningState &state = warningStates[test.warning];
+    uint32_t period = signals[rule.signal].periodMs;
+
+    reset();
+    uint32_t now = 1000;
+    for (const Segment *seg = test.trace; seg->ms; seg++) {
+      for (uint32_t t = 0; t < seg->ms; t += 10, now += 10) {
+        if (seg->updates && now % period == 0) {
+          feed(rule.signal, seg->level + noise(seg->noise), now);
+        }
+        checkStale(now);
+        evaluateWarnings(test.engRunning, now);
+      }
+    }
+
+    if (state.events != test.raised || state.active != test.activeAtEnd) {
+      fprintf(stderr, "%s: raised %u, %s at the end, expected %u, %s\n",
+              test.name, state.events, state.active ? "up" : "down",
+              test.raised, test.activeAtEnd ? "up" : "down");
+      testFailures++;
+    }
+  }
+
+  // the higher priority warning owns the layer
+  reset();
+  feed(SIG_COOLANT_TEMP, 1200, 1000);
+  feed(SIG_OIL_PRESSURE, 100, 1000);
+  for (uint32_t now = 1000; now <= 3000; now += 10) {
+    evaluateWarnings(true, now);
+  }
+  EXPECT(warningStates[WARN_COOLANT_HOT].active);
+  EXPECT(warningStates[WARN_OIL_PRESSURE].active);
+  EXPECT_EQ(topWarning(), WARN_OIL_PRESSURE);
+
+  fprintf(stderr, "%d warning traces\n", numCases);
+  return testResult("warnings");
+}